@@ -0,0 +1,32 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+/**
+ * @brief Writes a text file of the given size for the benchmarks
+ *
+ * The text is a repeated 1 MiB block of words, 11 per line, so wc has
+ * lines, words and spaces to count.
+ * @param path File to create (truncated if it exists)
+ * @param size File size in bytes
+ */
+inline void generateFile(const std::string& path, size_t size) {
+    std::string block;
+    const char* words[] = {"alpha", "beta", "gamma", "delta", "epsilon"};
+    for (size_t i = 0; block.size() < 1024 * 1024; i++) {
+        block += words[i % 5];
+        block += (i % 11 == 10) ? '\n' : ' ';
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    while (size > 0) {
+        size_t n = size < block.size() ? size : block.size();
+        file.write(block.data(), static_cast<std::streamsize>(n));
+        size -= n;
+    }
+}
+
+#endif
@@ -0,0 +1,376 @@
+// Regression benchmarks for the interpreter's hot paths: lexing, parsing
+// with variable expansion, cat/wc throughput, pipeline latency and
+// parallel fan-out.
+//
+// Usage: cli_bench [--filter SUBSTRING] [--min-time SECONDS] [--out FILE]
+//
+// Results are written as JSON (to stdout unless --out is given) in the
+// layout used by Google Benchmark, so two runs can be diffed with its
+// compare.py or any JSON tool.
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench_util.h"
+#include "commands/abstract_command.h"
+#include "commands/cat_command.h"
+#include "commands/parallel_command.h"
+#include "commands/wc_command.h"
+#include "environment_manager.h"
+#include "lexer.h"
+#include "parser.h"
+#include "source_sink.h"
+#include "variable_expander.h"
+
+namespace {
+
+/**
+ * @brief Sink dropping everything written to it
+ */
+class DiscardSink : public Sink {
+public:
+    bool write(const char*, size_t) override { return true; }
+    using Sink::write;
+};
+
+struct Result {
+    std::string name;
+    size_t iterations;
+    double realNs;
+    double cpuNs;
+    size_t bytesPerIteration;
+};
+
+struct Options {
+    std::string filter;
+    double minTime = 0.5;
+    std::string out;
+};
+
+// Runs op in growing batches until one batch takes at least minTime and
+// reports the per-iteration cost of that batch.
+Result measure(const std::string& name, double minTime,
+               const std::function<void()>& op, size_t bytesPerIteration) {
+    size_t iterations = 1;
+    while (true) {
+        std::clock_t cpuStart = std::clock();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            op();
+        }
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        double cpu = static_cast<double>(std::clock() - cpuStart) /
+                     CLOCKS_PER_SEC;
+
+        if (elapsed.count() >= minTime || iterations >= (1u << 30)) {
+            return {name, iterations, elapsed.count() * 1e9 / iterations,
+                    cpu * 1e9 / iterations, bytesPerIteration};
+        }
+
+        double scale = elapsed.count() > 0
+                           ? minTime / elapsed.count() * 1.4
+                           : 10.0;
+        size_t next = static_cast<size_t>(iterations * scale);
+        iterations = next > iterations * 10 ? iterations * 10
+                     : next > iterations    ? next
+                                            : iterations * 2;
+    }
+}
+
+std::string sizeLabel(size_t size) {
+    if (size >= 1024 * 1024) {
+        return std::to_string(size / (1024 * 1024)) + "MiB";
+    }
+    if (size >= 1024) {
+        return std::to_string(size / 1024) + "KiB";
+    }
+    return std::to_string(size) + "B";
+}
+
+std::string longLine(size_t size) {
+    std::string line = "echo";
+    for (size_t i = 0; line.size() < size; i++) {
+        switch (i % 4) {
+            case 0:
+                line += " word" + std::to_string(i);
+                break;
+            case 1:
+                line += " 'single quoted " + std::to_string(i) + "'";
+                break;
+            case 2:
+                line += " \"double $VAR" + std::to_string(i % 10) + "\"";
+                break;
+            default:
+                line += " | cat";
+                break;
+        }
+    }
+    return line;
+}
+
+// Pipeline of the given length ending in the builtin wc, so the result is
+// collected by the caller's sink instead of the process stdout.
+std::string pipelineLine(int stages, bool external) {
+    std::string line = external ? "/bin/echo hello" : "echo hello";
+    for (int i = 0; i < stages - 2; i++) {
+        line += external ? " | /bin/cat" : " | cat";
+    }
+    return line + " | wc";
+}
+
+// Expansion as done before VariableExpander: find + replace on a growing
+// string, quadratic in the number of references. Kept as a baseline.
+std::string legacyExpand(const std::string& text,
+                         const EnvironmentManager& env) {
+    std::string result = text;
+    size_t pos = 0;
+    while ((pos = result.find('$', pos)) != std::string::npos) {
+        size_t end = pos + 1;
+        while (end < result.length() &&
+               (std::isalnum(static_cast<unsigned char>(result[end])) ||
+                result[end] == '_')) {
+            end++;
+        }
+        if (end > pos + 1) {
+            std::string value(
+                env.getVariable(result.substr(pos + 1, end - pos - 1)));
+            result.replace(pos, end - pos, value);
+            pos += value.length();
+        } else {
+            pos++;
+        }
+    }
+    return result;
+}
+
+std::string toJson(const std::vector<Result>& results) {
+    std::time_t now = std::time(nullptr);
+    char date[64];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S",
+                  std::localtime(&now));
+
+    std::ostringstream json;
+    json << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"executable\": \"cli_bench\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+         // pipeline/builtin and pipeline/external run every stage as
+         // written; pipeline/optimized shows what the optimizer saves.
+         << "    \"pipeline_optimizer\": \"off except pipeline/optimized\"\n"
+         << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        json << (i ? ",\n" : "\n") << "    {\n"
+             << "      \"name\": \"" << r.name << "\",\n"
+             << "      \"run_name\": \"" << r.name << "\",\n"
+             << "      \"run_type\": \"iteration\",\n"
+             << "      \"iterations\": " << r.iterations << ",\n"
+             << "      \"real_time\": " << r.realNs << ",\n"
+             << "      \"cpu_time\": " << r.cpuNs << ",\n"
+             << "      \"time_unit\": \"ns\"";
+        if (r.bytesPerIteration > 0) {
+            json << ",\n      \"bytes_per_second\": "
+                 << r.bytesPerIteration * 1e9 / r.realNs;
+        }
+        json << "\n    }";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--filter") {
+            options.filter = argv[i + 1];
+        } else if (flag == "--min-time") {
+            options.minTime = std::atof(argv[i + 1]);
+        } else if (flag == "--out") {
+            options.out = argv[i + 1];
+        }
+    }
+
+    std::vector<Result> results;
+    auto run = [&](const std::string& name, const std::function<void()>& op,
+                   size_t bytesPerIteration = 0) {
+        if (name.find(options.filter) == std::string::npos) {
+            return;
+        }
+        std::cerr << name << std::endl;
+        results.push_back(
+            measure(name, options.minTime, op, bytesPerIteration));
+    };
+
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    for (int i = 0; i < 10; i++) {
+        env.setVariable("VAR" + std::to_string(i),
+                        "value of variable " + std::to_string(i));
+    }
+
+    // Lexer
+    Lexer lexer;
+    for (size_t size : {size_t{0}, size_t{64 * 1024}, size_t{1024 * 1024}}) {
+        std::string line = size == 0 ? "echo hello world | wc" : longLine(size);
+        std::string name =
+            "lexer/tokenize/" + (size == 0 ? "short" : sizeLabel(size));
+        run(name, [&] { lexer.tokenize(line); }, line.size());
+
+        std::vector<TokenView> views;
+        std::string viewName =
+            "lexer/tokenize_view/" + (size == 0 ? "short" : sizeLabel(size));
+        run(viewName, [&] { lexer.tokenizeView(line, views); }, line.size());
+    }
+
+    // Parser with variable expansion
+    Parser parser(env);
+    for (int refs : {10, 1000}) {
+        std::string quoted = "echo \"";
+        std::string words = "echo";
+        for (int i = 0; i < refs; i++) {
+            quoted += "$VAR" + std::to_string(i % 10) + " ";
+            words += " $VAR" + std::to_string(i % 10);
+        }
+        quoted += "\"";
+        auto quotedTokens = lexer.tokenize(quoted);
+        auto wordTokens = lexer.tokenize(words);
+        run("parser/expand_quoted/" + std::to_string(refs),
+            [&] { parser.parse(quotedTokens); });
+        run("parser/expand_words/" + std::to_string(refs),
+            [&] { parser.parse(wordTokens); });
+        run("parser/parse_line_cached/" + std::to_string(refs),
+            [&] { parser.parseLine(words); });
+    }
+
+    // Expansion of double-quoted text
+    for (auto [refs, valueSize] : {std::pair<int, size_t>{10000, 16},
+                                   std::pair<int, size_t>{8, 4 << 20}}) {
+        std::string text;
+        for (int i = 0; i < refs; i++) {
+            text += "$EXP" + std::to_string(i % 4) + " ";
+        }
+        for (int i = 0; i < 4; i++) {
+            env.setVariable("EXP" + std::to_string(i),
+                            std::string(valueSize, 'a' + i));
+        }
+        std::string suffix = std::to_string(refs) + "_refs/" +
+                             sizeLabel(valueSize) + "_values";
+        Word word = VariableExpander::compile(text);
+        size_t expandedSize = word.bind(env).size();
+
+        run("expand/compiled/" + suffix, [&] { word.bind(env); },
+            expandedSize);
+        run("expand/single_pass/" + suffix,
+            [&] { VariableExpander::expand(text, env); }, expandedSize);
+        if (refs <= 1000 || options.filter.find("legacy") !=
+                                std::string::npos) {
+            run("expand/legacy_find_replace/" + suffix,
+                [&] { legacyExpand(text, env); }, expandedSize);
+        }
+    }
+
+    // Builtin throughput
+    std::vector<size_t> fileSizes = {4 * 1024, 1024 * 1024,
+                                     64 * 1024 * 1024};
+    for (size_t size : fileSizes) {
+        std::string label = sizeLabel(size);
+        std::string path = "cli_bench_" + label + ".txt";
+        if (("wc/" + label).find(options.filter) == std::string::npos &&
+            ("cat/" + label).find(options.filter) == std::string::npos) {
+            continue;
+        }
+        generateFile(path, size);
+
+        run("wc/" + label, [&] {
+            WcCommand cmd(path);
+            StringSource input("");
+            StringSink output;
+            StringSink error;
+            cmd.execute(input, output, error);
+        }, size);
+        run("cat/" + label, [&] {
+            CatCommand cmd(path);
+            StringSource input("");
+            DiscardSink output;
+            StringSink error;
+            cmd.execute(input, output, error);
+        }, size);
+
+        std::remove(path.c_str());
+    }
+
+    // Pipeline latency, with every stage run as written
+#ifndef _WIN32
+    parser.setOptimize(false);
+    for (bool external : {false, true}) {
+        for (int stages : {2, 8, 64}) {
+            auto tokens = lexer.tokenize(pipelineLine(stages, external));
+            run(std::string("pipeline/") +
+                    (external ? "external/" : "builtin/") +
+                    std::to_string(stages),
+                [&] {
+                    auto command = parser.parse(tokens);
+                    StringSource input("");
+                    StringSink output;
+                    StringSink error;
+                    command->execute(input, output, error);
+                });
+        }
+    }
+    parser.setOptimize(true);
+    for (int stages : {2, 8, 64}) {
+        std::string line = pipelineLine(stages, false);
+        run("pipeline/optimized/" + std::to_string(stages), [&] {
+            auto command = parser.parseLine(line);
+            StringSource input("");
+            StringSink output;
+            StringSink error;
+            command->execute(input, output, error);
+        });
+    }
+
+    // Fan-out of short-lived programs: scales with the worker limit up to
+    // the number of cores.
+    std::vector<unsigned> jobLimits = {1};
+    if (std::thread::hardware_concurrency() > 1) {
+        jobLimits.push_back(std::thread::hardware_concurrency());
+    }
+    for (unsigned jobs : jobLimits) {
+        std::vector<std::string> args = {"-j", std::to_string(jobs),
+                                         "/bin/true", ":::"};
+        for (int i = 0; i < 64; i++) {
+            args.push_back(std::to_string(i));
+        }
+        run("parallel/true_x64/j" + std::to_string(jobs), [&] {
+            ParallelCommand cmd(args);
+            StringSource input("");
+            StringSink output;
+            StringSink error;
+            cmd.execute(input, output, error);
+        });
+    }
+#endif
+
+    std::string json = toJson(results);
+    if (options.out.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream(options.out) << json;
+    }
+    return 0;
+}
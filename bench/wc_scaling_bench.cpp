@@ -0,0 +1,84 @@
+// Measures how WcCommand scales with worker threads on one large file.
+//
+// Usage: wc_scaling_bench [--file PATH] [--size BYTES] [--max-threads N]
+//
+// Without --file a text file of --size bytes (default 10 GiB) is generated
+// in the current directory and removed afterwards.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "bench_util.h"
+#include "commands/wc_command.h"
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    size_t size = 10ull * 1024 * 1024 * 1024;
+    unsigned maxThreads = std::thread::hardware_concurrency();
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--file") {
+            path = argv[i + 1];
+        } else if (flag == "--size") {
+            size = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (flag == "--max-threads") {
+            maxThreads = static_cast<unsigned>(std::atoi(argv[i + 1]));
+        }
+    }
+    if (maxThreads == 0) {
+        maxThreads = 1;
+    }
+
+    bool generated = path.empty();
+    if (generated) {
+        path = "wc_scaling_bench.txt";
+        std::cerr << "Generating " << size << " bytes in " << path
+                  << std::endl;
+        generateFile(path, size);
+    }
+
+    WcCommand::setParallelThreshold(0);
+
+    double baseline = 0;
+    std::cout << "threads  seconds  GiB/s  speedup" << std::endl;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        WcCommand::setMaxThreads(threads);
+        WcCommand cmd(path);
+        std::istringstream input;
+        std::ostringstream output;
+
+        auto start = std::chrono::steady_clock::now();
+        int ret = cmd.execute(input, output, std::cerr);
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        if (ret != 0) {
+            break;
+        }
+        if (threads == 1) {
+            baseline = elapsed.count();
+        }
+
+        std::ifstream probe(path, std::ios::binary | std::ios::ate);
+        double gib = static_cast<double>(probe.tellg()) / (1 << 30);
+        std::printf("%7u  %7.3f  %5.2f  %7.2f\n", threads, elapsed.count(),
+                    gib / elapsed.count(), baseline / elapsed.count());
+
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+
+    if (generated) {
+        std::remove(path.c_str());
+    }
+    return 0;
+}
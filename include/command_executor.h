@@ -4,10 +4,15 @@
 #include <iostream>
 #include <memory>
 
+#include "source_sink.h"
+
 class AbstractCommand;
 
 /**
  * @brief Executes commands with specified I/O streams
+ *
+ * Runs foreground commands: after each one, `$PIPESTATUS` is set to its
+ * exit code, or to the codes of all stages of a pipeline.
  */
 class CommandExecutor {
 public:
@@ -22,6 +27,17 @@ public:
     int execute(AbstractCommand* command, std::istream& input = std::cin,
                 std::ostream& output = std::cout,
                 std::ostream& error = std::cerr);
+
+    /**
+     * @brief Executes command on byte sources and sinks
+     * @param command Command to execute
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
+     * @return Command exit code
+     */
+    int execute(AbstractCommand* command, Source& input, Sink& output,
+                Sink& error);
 };
 
 #endif
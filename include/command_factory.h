@@ -1,14 +1,37 @@
 #ifndef COMMAND_FACTORY_H
 #define COMMAND_FACTORY_H
 
+#include <deque>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 class AbstractCommand;
 
+/**
+ * @brief Function creating a built-in command from its arguments
+ */
+using BuiltinCreator = std::unique_ptr<AbstractCommand> (*)(
+    const std::vector<std::string>& args);
+
+/**
+ * @brief Identifies a built-in command within one CommandFactory
+ */
+using BuiltinId = int;
+
+/**
+ * @brief BuiltinId of commands that are not built in
+ */
+constexpr BuiltinId kNoBuiltin = -1;
+
 /**
  * @brief Creates command objects based on command name and arguments
+ *
+ * The standard builtins live in a constexpr table sorted by name, so
+ * looking a name up is a binary search with no allocation. More builtins
+ * can be added with registerBuiltin.
  */
 class CommandFactory {
 public:
@@ -19,10 +42,53 @@ public:
      * @return Unique pointer to created command
      */
     std::unique_ptr<AbstractCommand> createCommand(
-        const std::string& name, const std::vector<std::string>& args);
+        const std::string& name, const std::vector<std::string>& args) const;
+
+    /**
+     * @brief Creates command object for an already looked up name
+     * @param builtin Builtin found by findBuiltin (kNoBuiltin for external)
+     * @param name Command name
+     * @param args Command arguments
+     * @return Unique pointer to created command
+     */
+    std::unique_ptr<AbstractCommand> createCommand(
+        BuiltinId builtin, const std::string& name,
+        const std::vector<std::string>& args) const;
+
+    /**
+     * @brief Looks up a built-in command by name
+     * @param name Command name
+     * @return Builtin identifier, or kNoBuiltin for external programs
+     */
+    BuiltinId findBuiltin(std::string_view name) const;
+
+    /**
+     * @brief Looks up a name among the standard builtins only
+     *
+     * findBuiltin returns this identifier unless the builtin was replaced
+     * with registerBuiltin.
+     * @param name Command name
+     * @return Builtin identifier, or kNoBuiltin if name is not standard
+     */
+    static BuiltinId standardBuiltin(std::string_view name);
+
+    /**
+     * @brief Adds a built-in command or replaces an existing one
+     * @param name Command name
+     * @param create Function creating the command
+     * @return Identifier of the builtin
+     */
+    BuiltinId registerBuiltin(const std::string& name, BuiltinCreator create);
 
 private:
-    bool isBuiltinCommand(const std::string& name) const;
+    struct Registered {
+        std::string name;
+        BuiltinCreator create;
+    };
+
+    // A deque keeps the names in place, so the index can refer to them.
+    std::deque<Registered> registered_;
+    std::unordered_map<std::string_view, BuiltinId> registeredIds_;
 };
 
 #endif
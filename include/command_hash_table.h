@@ -0,0 +1,85 @@
+#ifndef COMMAND_HASH_TABLE_H
+#define COMMAND_HASH_TABLE_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Remembers where external commands were found in PATH (singleton)
+ *
+ * The first run of a command walks PATH; later runs reuse the stored
+ * absolute path. The table is cleared when PATH is reassigned and an entry
+ * is dropped when executing its path fails.
+ */
+class CommandHashTable {
+public:
+    /**
+     * @brief Single remembered command
+     */
+    struct Entry {
+        std::string name;
+        std::string path;
+        size_t hits = 0;
+    };
+
+    /**
+     * @brief Gets singleton instance
+     * @return Reference to singleton instance
+     */
+    static CommandHashTable& getInstance();
+
+    /**
+     * @brief Returns path of program, searching PATH on a miss
+     * @param program Program name (returned as is if it contains '/')
+     * @param searchPath PATH value to search on a miss
+     * @return Path to executable, or empty string if not found
+     */
+    std::string find(const std::string& program, const std::string& searchPath);
+
+    /**
+     * @brief Searches PATH for program and remembers the result
+     * @param program Program name
+     * @param searchPath PATH value to search
+     * @return true if program was found
+     */
+    bool add(const std::string& program, const std::string& searchPath);
+
+    /**
+     * @brief Forgets one program
+     * @param program Program name
+     */
+    void remove(const std::string& program);
+
+    /**
+     * @brief Forgets all programs
+     */
+    void clear();
+
+    /**
+     * @brief Gets remembered programs
+     * @return Entries sorted by name
+     */
+    std::vector<Entry> entries() const;
+
+    /**
+     * @brief Looks up program in a PATH-style directory list
+     * @param program Program name (returned as is if it contains '/')
+     * @param searchPath Directory list separated by ':' (';' on Windows)
+     * @return Path to executable, or empty string if not found
+     */
+    static std::string search(const std::string& program,
+                              const std::string& searchPath);
+
+private:
+    CommandHashTable() = default;
+    CommandHashTable(const CommandHashTable&) = delete;
+    CommandHashTable& operator=(const CommandHashTable&) = delete;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef COMMAND_PLAN_H
+#define COMMAND_PLAN_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "command_factory.h"
+#include "io_redirector.h"
+
+class AbstractCommand;
+class EnvironmentManager;
+class EnvironmentSnapshot;
+
+/**
+ * @brief Piece of a word: literal text or a variable reference
+ */
+struct WordSegment {
+    enum class Kind { Literal, Variable };
+
+    Kind kind;
+    std::string text;  // literal text, or variable name ("?" for $?)
+};
+
+/**
+ * @brief Command word whose value is known once variables are bound
+ */
+class Word {
+public:
+    /**
+     * @brief Appends literal text (merged with a preceding literal)
+     * @param text Literal text
+     */
+    void appendLiteral(std::string_view text);
+
+    /**
+     * @brief Appends a variable reference
+     * @param name Variable name
+     */
+    void appendVariable(std::string_view name);
+
+    /**
+     * @brief Checks if word has no variable references
+     * @return true if word is a plain literal
+     */
+    bool isLiteral() const;
+
+    /**
+     * @brief Gets word segments
+     * @return Segments in order
+     */
+    const std::vector<WordSegment>& segments() const { return segments_; }
+
+    /**
+     * @brief Computes word value with current variable values
+     * @param envManager Environment to take variable values from
+     * @return Word value
+     */
+    std::string bind(const EnvironmentManager& envManager) const;
+
+    /**
+     * @brief Computes word value with variable values of a snapshot
+     * @param snapshot Variables to take values from
+     * @return Word value
+     */
+    std::string bind(const EnvironmentSnapshot& snapshot) const;
+
+    /**
+     * @brief Formats word for display, quoted if needed
+     * @return Word as it could be typed (variables as ${NAME})
+     */
+    std::string describe() const;
+
+private:
+    std::vector<WordSegment> segments_;
+};
+
+/**
+ * @brief Redirection whose file name is known once variables are bound
+ */
+struct RedirectPlan {
+    Redirection::Kind kind;
+    int fd;
+    Word target;  // empty for Duplicate
+    int targetFd = -1;
+};
+
+/**
+ * @brief One command of a pipeline
+ */
+struct StagePlan {
+    std::vector<Word> words;  // command name first, then arguments
+    BuiltinId builtin = kNoBuiltin;  // valid if words[0] is literal
+    std::vector<RedirectPlan> redirects;  // in command line order
+};
+
+/**
+ * @brief Immutable result of parsing a line, independent of variables
+ *
+ * A plan is built once per distinct line and bound against the current
+ * environment on every execution.
+ */
+class CommandPlan {
+public:
+    /**
+     * @brief Creates plan for a variable assignment
+     * @param name Variable name
+     * @param value Value assigned as is (no expansion)
+     */
+    static std::shared_ptr<const CommandPlan> assignment(std::string name,
+                                                         std::string value);
+
+    /**
+     * @brief Creates plan for a command or pipeline
+     * @param stages Pipeline stages (a single stage for a plain command)
+     */
+    static std::shared_ptr<const CommandPlan> pipeline(
+        std::vector<StagePlan> stages);
+
+    /**
+     * @brief Creates plan for a command or pipeline started with `&`
+     * @param stages Pipeline stages
+     * @param text Command line shown by `jobs`
+     */
+    static std::shared_ptr<const CommandPlan> background(
+        std::vector<StagePlan> stages, std::string text);
+
+    /**
+     * @brief Creates copy of this plan with rewritten stages
+     * @param stages Stages left by PipelineOptimizer
+     * @param foldedStages Positions of the stages it removed
+     * @return Plan binding to a PipelineCommand that reports the removed
+     *         stages with status 0
+     */
+    std::shared_ptr<const CommandPlan> rewritten(
+        std::vector<StagePlan> stages, std::vector<size_t> foldedStages) const;
+
+    /**
+     * @brief Checks if plan is a variable assignment
+     * @return true for assignments
+     */
+    bool isAssignment() const { return isAssignment_; }
+
+    /**
+     * @brief Checks if plan runs as a background job
+     * @return true for plans created by background()
+     */
+    bool isBackground() const { return isBackground_; }
+
+    /**
+     * @brief Gets pipeline stages
+     * @return Stages in order (empty for assignments)
+     */
+    const std::vector<StagePlan>& stages() const { return stages_; }
+
+    /**
+     * @brief Formats plan as a command line (for `set -o showplan`)
+     *
+     * In-memory input left by PipelineOptimizer is shown as `<<< text`.
+     * @return Stages with their redirections, separated by `|`
+     */
+    std::string describe() const;
+
+    /**
+     * @brief Binds plan against the environment
+     *
+     * Assignments are performed here and produce no command; otherwise
+     * words are expanded against one snapshot of the environment and
+     * the commands are created; background plans are wrapped in a
+     * BackgroundCommand.
+     * @param envManager Environment for variable values and assignments
+     * @param factory Factory that resolved the plan's builtin IDs
+     * @return Unique pointer to command, or nullptr if no command
+     */
+    std::unique_ptr<AbstractCommand> bind(EnvironmentManager& envManager,
+                                          const CommandFactory& factory) const;
+
+private:
+    CommandPlan() = default;
+
+    bool isAssignment_ = false;
+    bool isBackground_ = false;
+    std::string name_;
+    std::string value_;
+    std::string text_;
+    std::vector<StagePlan> stages_;
+    std::vector<size_t> foldedStages_;
+};
+
+#endif
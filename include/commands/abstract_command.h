@@ -3,6 +3,8 @@
 
 #include <iostream>
 
+#include "source_sink.h"
+
 /**
  * @brief Abstract base class for all commands
  */
@@ -15,13 +17,29 @@ public:
 
     /**
      * @brief Executes command
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
+     * @return Exit code (0 for success)
+     */
+    virtual int execute(Source& input, Sink& output, Sink& error) = 0;
+
+    /**
+     * @brief Executes command on iostreams
+     *
+     * Wraps the streams in StreamSource/StreamSink adapters.
      * @param input Input stream
      * @param output Output stream
      * @param error Error stream
      * @return Exit code (0 for success)
      */
-    virtual int execute(std::istream& input, std::ostream& output,
-                        std::ostream& error) = 0;
+    int execute(std::istream& input, std::ostream& output,
+                std::ostream& error) {
+        StreamSource source(input);
+        StreamSink outputSink(output);
+        StreamSink errorSink(error);
+        return execute(source, outputSink, errorSink);
+    }
 };
 
 #endif
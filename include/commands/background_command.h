@@ -0,0 +1,42 @@
+#ifndef BACKGROUND_COMMAND_H
+#define BACKGROUND_COMMAND_H
+
+#include <memory>
+#include <string>
+
+#include "abstract_command.h"
+
+/**
+ * @brief Command started with `&`: runs without being waited for
+ *
+ * An external program is started directly; anything else runs in a forked
+ * copy of the interpreter. The job reads from /dev/null, writes to the
+ * interpreter's stdout and stderr and is added to JobTable.
+ */
+class BackgroundCommand : public AbstractCommand {
+public:
+    /**
+     * @brief Constructs background command
+     * @param command Command to run in the background
+     * @param text Command line shown by `jobs`
+     */
+    BackgroundCommand(std::unique_ptr<AbstractCommand> command,
+                      std::string text);
+
+    /**
+     * @brief Starts the command and returns at once
+     * @param input Input source (not used by the job)
+     * @param output Output sink (flushed before the job starts)
+     * @param error Error sink (gets "[N] PID" if JobTable notifies)
+     * @return 0 if the job was started, 127 if the program was not found,
+     *         1 on other errors
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+private:
+    std::unique_ptr<AbstractCommand> command_;
+    std::string text_;
+};
+
+#endif
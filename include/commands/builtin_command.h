@@ -12,6 +12,16 @@ public:
      * @brief Virtual destructor
      */
     virtual ~BuiltinCommand() = default;
+
+    /**
+     * @brief Checks if command changes interpreter state
+     *
+     * Pipeline stages run builtins on threads inside the interpreter;
+     * commands returning true run in a forked child instead, so that
+     * e.g. `exit` in a pipeline does not terminate the interpreter.
+     * @return true if command modifies interpreter state
+     */
+    virtual bool modifiesInterpreterState() const { return false; }
 };
 
 #endif
@@ -18,13 +18,13 @@ public:
 
     /**
      * @brief Executes cat command
-     * @param input Input stream (used when no file specified)
-     * @param output Output stream
-     * @param error Error stream
+     * @param input Input source (used when no file specified)
+     * @param output Output sink
+     * @param error Error sink
      * @return Exit code (0 for success, 1 for error)
      */
-    int execute(std::istream& input, std::ostream& output,
-                std::ostream& error) override;
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
 
 private:
     std::string filename_;
@@ -19,13 +19,13 @@ public:
 
     /**
      * @brief Executes echo command
-     * @param input Input stream
-     * @param output Output stream
-     * @param error Error stream
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
      * @return Exit code (always 0)
      */
-    int execute(std::istream& input, std::ostream& output,
-                std::ostream& error) override;
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
 
 private:
     std::vector<std::string> args_;
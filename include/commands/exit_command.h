@@ -15,13 +15,19 @@ public:
 
     /**
      * @brief Executes exit command - sets exit flag
-     * @param input Input stream
-     * @param output Output stream
-     * @param error Error stream
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
      * @return Exit code (always 0)
      */
-    int execute(std::istream& input, std::ostream& output,
-                std::ostream& error) override;
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Exit terminates the interpreter
+     * @return true
+     */
+    bool modifiesInterpreterState() const override { return true; }
 
     /**
      * @brief Checks if exit was requested
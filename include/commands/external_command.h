@@ -6,6 +6,10 @@
 
 #include "abstract_command.h"
 
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
 /**
  * @brief Represents external program command
  */
@@ -21,13 +25,30 @@ public:
 
     /**
      * @brief Executes external program
-     * @param input Input stream
-     * @param output Output stream
-     * @param error Error stream
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
      * @return Program exit code
      */
-    int execute(std::istream& input, std::ostream& output,
-                std::ostream& error) override;
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+#ifndef _WIN32
+    /**
+     * @brief Starts program as a pipeline stage without waiting for it
+     * @param inFd Descriptor to use as stdin (-1 to inherit)
+     * @param outFd Descriptor to use as stdout (-1 to inherit)
+     * @param errFd Descriptor to use as stderr (-1 to inherit)
+     * @return pid_t of child process, or -1 on error (errno is set)
+     */
+    pid_t spawn(int inFd, int outFd, int errFd = -1);
+#endif
+
+    /**
+     * @brief Gets program name
+     * @return Program name or path as given on the command line
+     */
+    const std::string& program() const { return program_; }
 
 private:
     std::string program_;
@@ -0,0 +1,43 @@
+#ifndef FG_COMMAND_H
+#define FG_COMMAND_H
+
+#include <string>
+#include <vector>
+
+#include "builtin_command.h"
+
+/**
+ * @brief Built-in fg command - brings a background job to the foreground
+ *
+ * Prints the job's command line and waits for it. Without job control
+ * the job keeps its input; only the waiting changes.
+ */
+class FgCommand : public BuiltinCommand {
+public:
+    /**
+     * @brief Constructs fg command
+     * @param args Job specification (`%N` or N), current job if empty
+     */
+    explicit FgCommand(const std::vector<std::string>& args);
+
+    /**
+     * @brief Executes fg command
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
+     * @return Exit code of the job, 1 if there is no such job
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Fg removes the job from the interpreter's job table
+     * @return true
+     */
+    bool modifiesInterpreterState() const override { return true; }
+
+private:
+    std::vector<std::string> args_;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef HASH_COMMAND_H
+#define HASH_COMMAND_H
+
+#include <string>
+#include <vector>
+
+#include "builtin_command.h"
+
+/**
+ * @brief Built-in hash command - shows and edits the command hash table
+ *
+ * Without arguments lists remembered commands, `hash NAME...` looks NAMEs
+ * up in PATH and remembers them, `hash -r` forgets everything.
+ */
+class HashCommand : public BuiltinCommand {
+public:
+    /**
+     * @brief Constructs hash command
+     * @param args Command arguments
+     */
+    explicit HashCommand(const std::vector<std::string>& args);
+
+    /**
+     * @brief Executes hash command
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
+     * @return Exit code (0 for success, 1 if a name was not found)
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Hash edits the interpreter's command table
+     * @return true
+     */
+    bool modifiesInterpreterState() const override { return true; }
+
+private:
+    std::vector<std::string> args_;
+};
+
+#endif
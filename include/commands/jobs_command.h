@@ -0,0 +1,35 @@
+#ifndef JOBS_COMMAND_H
+#define JOBS_COMMAND_H
+
+#include "builtin_command.h"
+
+/**
+ * @brief Built-in jobs command - lists background jobs
+ *
+ * Finished jobs are listed once with their status and then forgotten.
+ */
+class JobsCommand : public BuiltinCommand {
+public:
+    /**
+     * @brief Constructs jobs command
+     */
+    JobsCommand() = default;
+
+    /**
+     * @brief Executes jobs command
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
+     * @return Exit code (always 0)
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Jobs forgets the finished jobs it reports
+     * @return true
+     */
+    bool modifiesInterpreterState() const override { return true; }
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef PARALLEL_COMMAND_H
+#define PARALLEL_COMMAND_H
+
+#include <string>
+#include <vector>
+
+#include "builtin_command.h"
+
+/**
+ * @brief Built-in parallel command - runs a command once per argument
+ *
+ * `parallel [-j N] [-k] COMMAND [ARGS...] [::: INPUT...]` runs COMMAND
+ * for every INPUT (one per line of stdin if `:::` is not given), at most
+ * N at a time (default: number of cores, 0 means no limit). `{}` in
+ * COMMAND or ARGS is replaced by the input; without `{}` the input is
+ * appended as the last argument.
+ *
+ * Commands are started as external programs through ProcessManager, with
+ * stdin from /dev/null. One EventLoop collects the output of all runs and
+ * reaps them; the output of each run is written as one block when it
+ * finishes, in completion order or, with `-k`, in input order.
+ */
+class ParallelCommand : public BuiltinCommand {
+public:
+    /**
+     * @brief Constructs parallel command
+     * @param args Command arguments
+     */
+    explicit ParallelCommand(const std::vector<std::string>& args);
+
+    /**
+     * @brief Executes parallel command
+     * @param input Input source (inputs, if `:::` is not given)
+     * @param output Output sink
+     * @param error Error sink
+     * @return Number of failed runs (at most 101), 2 on usage errors
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+private:
+    std::vector<std::string> args_;
+};
+
+#endif
@@ -9,31 +9,58 @@
 /**
  * @brief Command that executes a pipeline of commands
  *
- * Connects stdout of each command to stdin of the next command using pipes.
- * All commands run in parallel in separate processes.
- * Returns the exit code of the last command in the pipeline.
+ * All commands run in parallel. Builtin stages run on threads inside the
+ * interpreter and pass data to neighbouring builtins through bounded
+ * in-memory ring buffers; external programs are forked and connected with
+ * real pipes. Processes are reaped as soon as they exit; the status of
+ * every stage is kept in stageExitCodes(), which CommandExecutor stores
+ * in `$PIPESTATUS` for foreground commands.
+ *
+ * Returns the exit code of the last command in the pipeline. With the
+ * pipefail option set, the first stage that fails terminates the
+ * remaining processes and its exit code is returned instead.
  */
 class PipelineCommand : public AbstractCommand {
 public:
     /**
      * @brief Constructs a pipeline command
      * @param commands Vector of commands to execute in pipeline
+     * @param foldedStages Positions of stages PipelineOptimizer removed
+     *        (increasing); they are reported with status 0 by
+     *        stageExitCodes()
      */
     explicit PipelineCommand(
-        std::vector<std::unique_ptr<AbstractCommand>> commands);
+        std::vector<std::unique_ptr<AbstractCommand>> commands,
+        std::vector<size_t> foldedStages = {});
 
     /**
      * @brief Executes the pipeline
-     * @param input Input stream for the first command
-     * @param output Output stream for the last command
-     * @param error Error stream (shared by all commands)
-     * @return Exit code of the last command
+     * @param input Input source for the first command
+     * @param output Output sink for the last command
+     * @param error Error sink (shared by all commands)
+     * @return Exit code of the last command (of the first failed one
+     *         under pipefail)
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Gets exit codes of all stages of the last execution
+     * @return Exit code of each stage, in the order of the pipeline as
+     *         written (folded stages included)
      */
-    int execute(std::istream& input, std::ostream& output,
-                std::ostream& error) override;
+    const std::vector<int>& stageExitCodes() const { return stageExitCodes_; }
 
 private:
     std::vector<std::unique_ptr<AbstractCommand>> commands_;
+    std::vector<size_t> foldedStages_;
+    std::vector<int> stageExitCodes_;
+
+    /**
+     * @brief Stores the statuses of the executed stages
+     * @param exitCodes Exit code of each command, in order
+     */
+    void recordStages(const std::vector<int>& exitCodes);
 };
 
 #endif
@@ -15,13 +15,13 @@ public:
 
     /**
      * @brief Executes pwd command
-     * @param input Input stream
-     * @param output Output stream
-     * @param error Error stream
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
      * @return Exit code (0 for success, 1 for error)
      */
-    int execute(std::istream& input, std::ostream& output,
-                std::ostream& error) override;
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
 };
 
 #endif
@@ -0,0 +1,59 @@
+#ifndef REDIRECTED_COMMAND_H
+#define REDIRECTED_COMMAND_H
+
+#include <memory>
+#include <vector>
+
+#include "abstract_command.h"
+#include "io_redirector.h"
+
+/**
+ * @brief Command with `<`, `>`, `>>`, `2>` or `2>&1` redirections
+ *
+ * Files are opened by IORedirector and handed to the command as
+ * FdSource/FdSink, so builtins write them with large buffered writes and
+ * external programs get the descriptors themselves. Pipeline stages
+ * running external programs apply the redirections to the descriptors of
+ * the child directly (see IORedirector::apply). Text redirections are
+ * only created by PipelineOptimizer and read from memory.
+ */
+class RedirectedCommand : public AbstractCommand {
+public:
+    /**
+     * @brief Constructs redirected command
+     * @param command Command to run
+     * @param redirections Redirections in command line order
+     */
+    RedirectedCommand(std::unique_ptr<AbstractCommand> command,
+                      std::vector<Redirection> redirections);
+
+    /**
+     * @brief Opens the files and runs the command on them
+     * @param input Input source, unless stdin is redirected
+     * @param output Output sink, unless stdout is redirected
+     * @param error Error sink, unless stderr is redirected
+     * @return Exit code of the command, 1 if a file cannot be opened
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Gets the command being redirected
+     * @return Command
+     */
+    AbstractCommand& command() const { return *command_; }
+
+    /**
+     * @brief Gets redirections
+     * @return Redirections in command line order
+     */
+    const std::vector<Redirection>& redirections() const {
+        return redirections_;
+    }
+
+private:
+    std::unique_ptr<AbstractCommand> command_;
+    std::vector<Redirection> redirections_;
+};
+
+#endif
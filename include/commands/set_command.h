@@ -0,0 +1,44 @@
+#ifndef SET_COMMAND_H
+#define SET_COMMAND_H
+
+#include <string>
+#include <vector>
+
+#include "builtin_command.h"
+
+/**
+ * @brief Built-in set command - shows variables and shell options
+ *
+ * Without arguments lists all variables, `set -o` lists options,
+ * `set -o NAME` / `set +o NAME` turns option NAME on / off. Options are
+ * pipefail and showplan (print each command's optimized plan on stderr).
+ */
+class SetCommand : public BuiltinCommand {
+public:
+    /**
+     * @brief Constructs set command
+     * @param args Command arguments
+     */
+    explicit SetCommand(const std::vector<std::string>& args);
+
+    /**
+     * @brief Executes set command
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
+     * @return Exit code (0 for success, 1 for unknown options)
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Set changes the interpreter's options
+     * @return true
+     */
+    bool modifiesInterpreterState() const override { return true; }
+
+private:
+    std::vector<std::string> args_;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef WAIT_COMMAND_H
+#define WAIT_COMMAND_H
+
+#include <string>
+#include <vector>
+
+#include "builtin_command.h"
+
+/**
+ * @brief Built-in wait command - waits for background jobs
+ *
+ * `wait` waits for all jobs, `wait SPEC...` for the given jobs (`%N` or
+ * a process ID).
+ */
+class WaitCommand : public BuiltinCommand {
+public:
+    /**
+     * @brief Constructs wait command
+     * @param args Job specifications
+     */
+    explicit WaitCommand(const std::vector<std::string>& args);
+
+    /**
+     * @brief Executes wait command
+     * @param input Input source
+     * @param output Output sink
+     * @param error Error sink
+     * @return 0 without arguments, otherwise exit code of the last job
+     *         (127 if it does not exist)
+     */
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Wait removes jobs from the interpreter's job table
+     * @return true
+     */
+    bool modifiesInterpreterState() const override { return true; }
+
+private:
+    std::vector<std::string> args_;
+};
+
+#endif
@@ -1,10 +1,13 @@
 #ifndef WC_COMMAND_H
 #define WC_COMMAND_H
 
+#include <atomic>
 #include <string>
 
 #include "builtin_command.h"
 
+class MappedFile;
+
 /**
  * @brief Built-in wc command - counts lines, words and bytes in file or stdin
  */
@@ -18,26 +21,67 @@ public:
 
     /**
      * @brief Executes wc command
-     * @param input Input stream (used when no file specified)
-     * @param output Output stream
-     * @param error Error stream
+     * @param input Input source (used when no file specified)
+     * @param output Output sink
+     * @param error Error sink
      * @return Exit code (0 for success, 1 for error)
      */
-    int execute(std::istream& input, std::ostream& output,
-                std::ostream& error) override;
+    int execute(Source& input, Sink& output, Sink& error) override;
+    using AbstractCommand::execute;
+
+    /**
+     * @brief Sets the size from which regular files are counted in parallel
+     * @param bytes Minimum file size for the multi-threaded path
+     */
+    static void setParallelThreshold(size_t bytes);
+
+    /**
+     * @brief Gets the size from which regular files are counted in parallel
+     * @return Threshold in bytes
+     */
+    static size_t parallelThreshold();
+
+    /**
+     * @brief Limits the number of threads used for large files
+     * @param threads Thread count (0 means one per hardware thread)
+     */
+    static void setMaxThreads(unsigned threads);
 
 private:
     std::string filename_;
 
+    // Atomic: builtin pipeline stages run on threads while tests and
+    // benchmarks tune these.
+    static std::atomic<size_t> parallelThreshold_;
+    static std::atomic<unsigned> maxThreads_;
+
     /**
-     * @brief Helper method to count lines, words, and bytes from a stream
-     * @param stream Input stream to count from
+     * @brief Helper method to count lines, words, and bytes from a source
+     *
+     * Counts the source's blocks with TextCounter; lines are newline
+     * characters, as in POSIX wc.
+     * @param source Input source to count from
      * @param lines Output: number of lines
      * @param words Output: number of words
      * @param bytes Output: number of bytes
+     * @return false on read error
      */
-    void countFromStream(std::istream& stream, size_t& lines, size_t& words,
+    bool countFromSource(Source& source, size_t& lines, size_t& words,
                          size_t& bytes);
+
+    /**
+     * @brief Counts an opened file
+     *
+     * Mapped files at or above the parallel threshold are split across
+     * threads; everything else goes through countFromSource.
+     * @param file Opened input file
+     * @param lines Output: number of lines
+     * @param words Output: number of words
+     * @param bytes Output: number of bytes
+     * @return false on read error
+     */
+    bool countFromFile(MappedFile& file, size_t& lines, size_t& words,
+                       size_t& bytes);
 };
 
 #endif
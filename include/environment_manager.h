@@ -1,11 +1,117 @@
 #ifndef ENVIRONMENT_MANAGER_H
 #define ENVIRONMENT_MANAGER_H
 
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "variable_table.h"
+
+/**
+ * @brief Immutable version of all variables
+ *
+ * Snapshots are shared between threads through shared_ptr; a holder can
+ * read it without locks while newer versions are published. Besides the
+ * variables, a snapshot carries `$PIPESTATUS`, which is interpreter state
+ * and never exported to new processes.
+ */
+class EnvironmentSnapshot {
+public:
+    /**
+     * @brief Constructs snapshot
+     * @param variables Variables of this version
+     * @param pipeStatus Value of `$PIPESTATUS`
+     * @param version Version number
+     * @param exitCode Exit code field shared by all snapshots (for `$?`)
+     */
+    EnvironmentSnapshot(VariableTable variables, std::string pipeStatus,
+                        uint64_t version, const std::atomic<int>& exitCode);
+
+    /**
+     * @brief Constructs snapshot with the variables of another one
+     *
+     * The variables and the environment built for new processes are
+     * shared, not copied.
+     * @param previous Snapshot to take the variables from
+     * @param pipeStatus Value of `$PIPESTATUS`
+     * @param version Version number
+     */
+    EnvironmentSnapshot(const EnvironmentSnapshot& previous,
+                        std::string pipeStatus, uint64_t version);
+
+    /**
+     * @brief Gets variable value
+     * @param name Variable name (`?` gives the current exit code,
+     *        `PIPESTATUS` the stage statuses of the last command)
+     * @return View of the value (valid while the snapshot is alive, and
+     *         for `?` until the program ends), or empty view if not found
+     */
+    std::string_view get(std::string_view name) const;
+
+    /**
+     * @brief Checks if variable exists
+     * @param name Variable name
+     * @return true if variable exists
+     */
+    bool has(std::string_view name) const;
+
+    /**
+     * @brief Gets environment for new processes
+     *
+     * Built on first use; all variables except `?` and `PIPESTATUS`.
+     * @return Null-terminated "NAME=value" array, valid while the snapshot
+     *         is alive
+     */
+    char* const* envp() const;
+
+    /**
+     * @brief Gets version number
+     * @return Version of the environment this snapshot was taken from
+     */
+    uint64_t version() const { return version_; }
+
+    /**
+     * @brief Gets variables
+     * @return Variable table
+     */
+    const VariableTable& variables() const { return exported_->variables; }
+
+    /**
+     * @brief Gets `$PIPESTATUS`
+     * @return Space separated statuses of the last foreground command
+     */
+    const std::string& pipeStatus() const { return pipeStatus_; }
+
+private:
+    // Shared by snapshots that differ only in PIPESTATUS.
+    struct Exported {
+        VariableTable variables;
+        std::once_flag envpOnce;
+        std::vector<std::string> envStrings;
+        std::vector<char*> envp;
+    };
+
+    std::shared_ptr<Exported> exported_;
+    std::string pipeStatus_;
+    uint64_t version_;
+    const std::atomic<int>& exitCode_;
+};
 
 /**
  * @brief Manages environment variables (singleton)
+ *
+ * The process environment is imported once, when the instance is
+ * created. Variables are published as copy-on-write snapshots: readers
+ * take the current snapshot without locking, setVariable copies it,
+ * applies the change and publishes the copy. The copy shares everything
+ * but the changed entry with its predecessor (see VariableTable). The
+ * exit code of the last command (`$?`) and the shell options are kept in
+ * their own fields, outside the snapshots.
  */
 class EnvironmentManager {
 public:
@@ -17,37 +123,133 @@ public:
 
     /**
      * @brief Sets environment variable
+     *
+     * Assigning PATH clears CommandHashTable; `?` is forwarded to
+     * setExitCode and publishes no new snapshot; `PIPESTATUS` replaces the
+     * statuses and stays unexported.
      * @param name Variable name
      * @param value Variable value
      */
-    void setVariable(const std::string& name, const std::string& value);
+    void setVariable(std::string_view name, std::string_view value);
 
     /**
      * @brief Gets environment variable value
+     *
+     * For several related lookups take a snapshot() instead, so they all
+     * see the same version.
      * @param name Variable name
-     * @return Variable value, or empty string if not found
+     * @return View of the value, or empty view if not found. The view
+     *         stays valid until the calling thread uses this object again
+     *         after the variable was changed.
      */
-    std::string getVariable(const std::string& name) const;
+    std::string_view getVariable(std::string_view name) const;
 
     /**
      * @brief Checks if variable exists
      * @param name Variable name
      * @return true if variable exists
      */
-    bool hasVariable(const std::string& name) const;
+    bool hasVariable(std::string_view name) const;
 
     /**
-     * @brief Gets all custom variables
-     * @return Map of all custom variables
+     * @brief Gets all variables
+     * @return Map of all variables, `?` and `PIPESTATUS` excluded
      */
     std::map<std::string, std::string> getAllVariables() const;
 
+    /**
+     * @brief Sets exit code of the last command (`$?`)
+     * @param code Exit code
+     */
+    void setExitCode(int code);
+
+    /**
+     * @brief Gets exit code of the last command (`$?`)
+     * @return Exit code
+     */
+    int exitCode() const { return exitCode_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Records the statuses of the last foreground command
+     *
+     * Sets `$PIPESTATUS`: one status for a single command, one per stage
+     * for a pipeline. Publishes a snapshot sharing the variables of the
+     * current one.
+     * @param statuses Exit codes in stage order
+     */
+    void setPipeStatus(const std::vector<int>& statuses);
+
+    /**
+     * @brief Sets the pipefail option (`set -o pipefail`)
+     * @param enabled true to make pipelines fail on the first failed stage
+     */
+    void setPipefail(bool enabled) {
+        pipefail_.store(enabled, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the pipefail option
+     * @return true if pipelines fail on the first failed stage
+     */
+    bool pipefail() const { return pipefail_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Sets the showplan option (`set -o showplan`)
+     * @param enabled true to print the optimized plan of every command
+     */
+    void setShowPlan(bool enabled) {
+        showPlan_.store(enabled, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the showplan option
+     * @return true if plans are printed before they run
+     */
+    bool showPlan() const { return showPlan_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Gets current snapshot of all variables
+     *
+     * Lock-free unless the environment changed since the calling thread
+     * last asked.
+     * @return Snapshot of the current version
+     */
+    std::shared_ptr<const EnvironmentSnapshot> snapshot() const;
+
+    /**
+     * @brief Gets environment for new processes
+     * @return Null-terminated "NAME=value" array of the current snapshot,
+     *         valid as long as a value returned by getVariable would be;
+     *         hold a snapshot() to keep it longer
+     */
+    char* const* envp() const;
+
+    /**
+     * @brief Gets counter incremented by every published snapshot
+     * @return Environment version
+     */
+    uint64_t version() const {
+        return version_.load(std::memory_order_acquire);
+    }
+
 private:
-    EnvironmentManager() = default;
+    EnvironmentManager();
     EnvironmentManager(const EnvironmentManager&) = delete;
     EnvironmentManager& operator=(const EnvironmentManager&) = delete;
 
-    std::map<std::string, std::string> variables_;
+    // Read with std::atomic_load, replaced with std::atomic_store.
+    std::shared_ptr<const EnvironmentSnapshot> current_;
+    std::atomic<uint64_t> version_{0};
+    std::atomic<int> exitCode_{0};
+    std::atomic<bool> pipefail_{false};
+    std::atomic<bool> showPlan_{false};
+    std::mutex writeMutex_;
+
+    /**
+     * @brief Publishes a new current snapshot (writeMutex_ held)
+     * @param snapshot Snapshot one version after the current one
+     */
+    void publish(std::shared_ptr<const EnvironmentSnapshot> snapshot);
 };
 
 #endif
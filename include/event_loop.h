@@ -0,0 +1,158 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#ifndef _WIN32
+#include <sys/types.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Waits for descriptors, child processes and signals at once
+ *
+ * Sources are registered with a handler and dispatched from runOnce() or
+ * run() on the thread owning the loop:
+ * - descriptors (input, pipes pumped by the interpreter)
+ * - child processes, through pidfds; the loop reaps them itself
+ * - signals, through signalfd
+ *
+ * The epoll backend is used where available and poll() elsewhere. Where
+ * pidfds are not available children are checked with WNOHANG on a short,
+ * backing-off timer; where signalfd is not, a self-pipe is used.
+ *
+ * Handlers may register and remove sources, including their own.
+ */
+class EventLoop {
+public:
+    enum class Backend { Epoll, Poll };
+
+    /** @brief Descriptor can be read (or reached end of file) */
+    static constexpr uint32_t kReadable = 1;
+    /** @brief Descriptor can be written */
+    static constexpr uint32_t kWritable = 2;
+    /** @brief Peer closed the descriptor or an error occurred */
+    static constexpr uint32_t kClosed = 4;
+
+    using IoHandler = std::function<void(uint32_t events)>;
+    using ChildHandler = std::function<void(int exitCode)>;
+    using SignalHandler = std::function<void(int signo)>;
+
+    /**
+     * @brief Creates loop with the best available backend
+     */
+    EventLoop();
+
+    /**
+     * @brief Creates loop with the given backend
+     * @param backend Backend to use (Epoll falls back to Poll if epoll is
+     *        not available)
+     */
+    explicit EventLoop(Backend backend);
+
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Gets the interpreter's loop
+     *
+     * Owned by the interpreter thread: it waits there for input,
+     * background jobs and signals.
+     * @return Reference to the shared loop
+     */
+    static EventLoop& shared();
+
+    /**
+     * @brief Gets backend in use
+     * @return Epoll or Poll
+     */
+    Backend backend() const { return backend_; }
+
+    /**
+     * @brief Starts watching a descriptor
+     * @param fd Descriptor (not owned by the loop)
+     * @param events kReadable and/or kWritable
+     * @param handler Called with the ready events (plus kClosed)
+     * @return true if registered
+     */
+    bool watch(int fd, uint32_t events, IoHandler handler);
+
+    /**
+     * @brief Stops watching a descriptor
+     * @param fd Descriptor passed to watch()
+     */
+    void unwatch(int fd);
+
+    /**
+     * @brief Starts watching a child process
+     *
+     * The loop reaps the child when it exits; nobody else may wait for it.
+     * @param pid Child process ID
+     * @param handler Called with the exit code (128 + signal number for
+     *        children killed by a signal)
+     */
+    void watchChild(pid_t pid, ChildHandler handler);
+
+    /**
+     * @brief Starts watching a signal
+     *
+     * The signal is blocked in the calling thread and delivered to
+     * handler from the loop instead.
+     * @param signo Signal number
+     * @param handler Called once per received signal
+     * @return true if registered
+     */
+    bool watchSignal(int signo, SignalHandler handler);
+
+    /**
+     * @brief Waits for events once and dispatches them
+     * @param timeoutMs Maximum wait in milliseconds (-1 waits forever)
+     * @return false if there is nothing to wait for
+     */
+    bool runOnce(int timeoutMs = -1);
+
+    /**
+     * @brief Dispatches events until stop() is called or nothing is left
+     */
+    void run();
+
+    /**
+     * @brief Makes run() return after the current dispatch round
+     */
+    void stop() { stopped_ = true; }
+
+    /**
+     * @brief Checks whether anything is registered
+     * @return true if there is nothing to wait for
+     */
+    bool empty() const { return watches_.empty() && polledChildren_.empty(); }
+
+private:
+    struct Watch {
+        uint32_t events;
+        std::shared_ptr<IoHandler> handler;
+    };
+
+    struct PolledChild {
+        pid_t pid;
+        ChildHandler handler;
+    };
+
+    void dispatch(int fd, uint32_t events);
+    bool reapPolledChildren();
+
+    Backend backend_;
+    int epollFd_ = -1;
+    std::unordered_map<int, Watch> watches_;
+    std::vector<int> ownedFds_;  // pidfds and signal descriptors
+    std::vector<PolledChild> polledChildren_;
+    int pollDelayMs_ = 1;
+    bool stopped_ = false;
+};
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef FD_TRANSFER_H
+#define FD_TRANSFER_H
+
+#include <cstddef>
+#include <iostream>
+
+class Source;
+class Sink;
+
+/**
+ * @brief Moves file contents between descriptors and streams
+ *
+ * When both ends are file descriptors the data is copied inside the kernel:
+ * copy_file_range or sendfile for regular files and sockets, splice for
+ * pipes. Other ends get a blocked, byte-exact copy.
+ */
+class FdTransfer {
+public:
+    /**
+     * @brief Size of the buffer used by the blocked fallback paths
+     */
+    static constexpr size_t kBlockSize = 128 * 1024;
+
+    /**
+     * @brief Copies everything from inFd (from its current offset) to outFd
+     * @param inFd Descriptor to read from
+     * @param outFd Descriptor to write to
+     * @return true on success, false on I/O error (errno is preserved)
+     */
+    static bool copy(int inFd, int outFd);
+
+    /**
+     * @brief Copies a source to a sink
+     *
+     * Uses copy(int, int) when both ends expose a descriptor, otherwise
+     * writes the source's blocks to the sink as they come.
+     * @param input Source to read from
+     * @param output Sink to write to
+     * @return true on success, false on read or write error
+     */
+    static bool copy(Source& input, Sink& output);
+
+    /**
+     * @brief Returns the descriptor behind an output stream
+     * @param stream Stream to inspect
+     * @return STDOUT/STDERR descriptor if stream writes to the process
+     *         stdout/stderr or into a SinkStreambuf over a descriptor sink,
+     *         -1 otherwise
+     */
+    static int streamDescriptor(const std::ostream& stream);
+
+    /**
+     * @brief Returns the descriptor behind an input stream
+     *
+     * The descriptor is not positioned after bytes the stream has already
+     * buffered; only hand it to readers that start fresh (child processes).
+     * @param stream Stream to inspect
+     * @return STDIN descriptor if stream reads the process stdin, the
+     *         descriptor of a SourceStreambuf over a descriptor source,
+     *         -1 otherwise
+     */
+    static int streamDescriptor(const std::istream& stream);
+};
+
+#endif
@@ -1,9 +1,14 @@
 #ifndef INPUT_PROCESSOR_H
 #define INPUT_PROCESSOR_H
 
+#include <functional>
 #include <istream>
 #include <string>
 
+#ifndef _WIN32
+class EventLoop;
+#endif
+
 /**
  * @brief Reads user input from standard input stream
  */
@@ -15,6 +20,19 @@ public:
      */
     explicit InputProcessor(std::istream& input);
 
+#ifndef _WIN32
+    /**
+     * @brief Constructs InputProcessor waiting for a descriptor in a loop
+     *
+     * While no complete line is available, readLine keeps dispatching the
+     * loop's other events (background jobs, signals).
+     * @param fd Descriptor to read from (not owned)
+     * @param loop Loop to wait in
+     * @param onWait Called after every dispatch round while waiting
+     */
+    InputProcessor(int fd, EventLoop& loop, std::function<void()> onWait);
+#endif
+
     /**
      * @brief Reads one line from input stream
      * @param line Output parameter to store read line
@@ -23,7 +41,17 @@ public:
     bool readLine(std::string& line);
 
 private:
-    std::istream& input_;
+    std::istream* input_ = nullptr;
+
+#ifndef _WIN32
+    bool readFromDescriptor(std::string& line);
+
+    int fd_ = -1;
+    EventLoop* loop_ = nullptr;
+    std::function<void()> onWait_;
+    std::string buffer_;
+    bool eof_ = false;
+#endif
 };
 
 #endif
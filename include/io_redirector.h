@@ -1,16 +1,49 @@
 #ifndef IO_REDIRECTOR_H
 #define IO_REDIRECTOR_H
 
+#include <array>
+#include <string>
 #include <vector>
 
+/**
+ * @brief Redirection of one standard descriptor of a command
+ */
+struct Redirection {
+    enum class Kind {
+        Input,      // `< file`
+        Output,     // `> file` (truncates)
+        Append,     // `>> file`
+        Duplicate,  // `N>&M`: N becomes a copy of M
+        Text        // stdin reads target and a newline, like `<<< text`
+    };
+
+    Kind kind;
+    int fd;              // redirected descriptor: 0, 1 or 2
+    std::string target;  // file name, or the text for Text
+    int targetFd = -1;   // descriptor copied by Duplicate
+};
+
 /**
  * @brief Manages I/O redirection for pipeline commands
  *
- * Creates and manages pipes between commands in a pipeline.
- * Handles file descriptor setup for child processes.
+ * Creates and manages pipes between commands in a pipeline and opens the
+ * files of redirections. Handles file descriptor setup for child
+ * processes.
  */
 class IORedirector {
 public:
+    /**
+     * @brief Creates a close-on-exec pipe
+     *
+     * The flag is set atomically with pipe2() where available, so a
+     * process spawned by another thread meanwhile cannot inherit an end
+     * (its reader would then never see end of file). macOS has no pipe2()
+     * and sets it right after pipe().
+     * @param fds Output: read end and write end
+     * @return true if successful (errno set otherwise)
+     */
+    static bool openPipe(int fds[2]);
+
     /**
      * @brief Creates pipes for pipeline
      * @param count Number of pipes to create (n-1 for n commands)
@@ -18,6 +51,18 @@ public:
      */
     bool createPipes(int count);
 
+    /**
+     * @brief Creates pipes only for selected links of a pipeline
+     *
+     * Link i connects command i to command i + 1. Links that are not
+     * selected get no pipe (e.g. they are served by an in-memory buffer).
+     * Pipes are close-on-exec, so exec'd children only keep the ends
+     * duplicated onto their stdin/stdout.
+     * @param links One flag per link
+     * @return true if successful, false on error
+     */
+    bool createPipes(const std::vector<bool>& links);
+
     /**
      * @brief Sets up pipes for a child process at given index
      * @param index Index of the command in the pipeline (0-based)
@@ -26,7 +71,60 @@ public:
     void setupChildPipes(int index, int totalCommands);
 
     /**
-     * @brief Closes all pipe file descriptors
+     * @brief Gets read end of a link's pipe
+     * @param link Link index
+     * @return Descriptor, or -1 if the link has no pipe
+     */
+    int readEnd(int link) const;
+
+    /**
+     * @brief Gets write end of a link's pipe
+     * @param link Link index
+     * @return Descriptor, or -1 if the link has no pipe
+     */
+    int writeEnd(int link) const;
+
+    /**
+     * @brief Takes ownership of a link's read end away from the redirector
+     * @param link Link index
+     * @return Descriptor (caller closes it), or -1 if none
+     */
+    int releaseReadEnd(int link);
+
+    /**
+     * @brief Takes ownership of a link's write end away from the redirector
+     * @param link Link index
+     * @return Descriptor (caller closes it), or -1 if none
+     */
+    int releaseWriteEnd(int link);
+
+    /**
+     * @brief Opens the file of a redirection
+     * @param redirection Input, Output or Append redirection
+     * @return Close-on-exec descriptor owned by the redirector, or -1 on
+     *         error (errno is set)
+     */
+    int openFile(const Redirection& redirection);
+
+    /**
+     * @brief Applies a redirection to the descriptors of a command
+     *
+     * Applied in command line order like in a shell, `> f 2>&1` sends both
+     * outputs to f while `2>&1 > f` keeps errors on the previous stdout.
+     * Nothing is copied: the command simply gets other descriptors
+     * (dup2'ed by the child when it starts). Text redirections need a
+     * pipe fed by the caller and are not handled here.
+     * @param redirection File or Duplicate redirection
+     * @param fds Descriptors for stdin, stdout and stderr, updated in place
+     * @param errorMessage Output: "file: reason" if the file cannot be
+     *        opened
+     * @return true on success
+     */
+    bool apply(const Redirection& redirection, std::array<int, 3>& fds,
+               std::string& errorMessage);
+
+    /**
+     * @brief Closes all pipe and redirection file descriptors
      *
      * Must be called in parent process after all children are forked
      * and in each child process after pipe setup
@@ -39,7 +137,8 @@ public:
     ~IORedirector();
 
 private:
-    std::vector<int*> pipes_;
+    std::vector<std::array<int, 2>> pipes_;
+    std::vector<int> files_;
 };
 
 #endif
@@ -0,0 +1,125 @@
+#ifndef JOB_TABLE_H
+#define JOB_TABLE_H
+
+#ifndef _WIN32
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Background jobs started with `&` (singleton)
+ *
+ * Each job is one child process: the program itself, or a forked copy of
+ * the interpreter running a pipeline or builtin. Jobs are watched by the
+ * interpreter's EventLoop, which reaps them whenever it runs: while
+ * waiting for input, in reapFinished() and in wait().
+ *
+ * Only the interpreter process reaps: in a forked child the table is a
+ * stale copy and reaping calls do nothing.
+ */
+class JobTable {
+public:
+    enum class State { Running, Done };
+
+    /**
+     * @brief Single background job
+     */
+    struct Job {
+        int id;
+        pid_t pid;
+        std::string command;
+        State state;
+        int exitCode;
+    };
+
+    /**
+     * @brief Gets singleton instance
+     * @return Reference to singleton instance
+     */
+    static JobTable& getInstance();
+
+    /**
+     * @brief Adds a started job
+     * @param pid Child process ID
+     * @param command Command line shown by `jobs`
+     * @return Job number
+     */
+    int add(pid_t pid, const std::string& command);
+
+    /**
+     * @brief Reaps finished jobs without blocking
+     *
+     * Dispatches whatever is pending in the interpreter's loop. Finished
+     * jobs stay in the table until they are reported (see
+     * takeFinished) or waited for.
+     */
+    void reapFinished();
+
+    /**
+     * @brief Gets all jobs
+     * @return Jobs sorted by number
+     */
+    std::vector<Job> jobs() const;
+
+    /**
+     * @brief Removes finished jobs from the table
+     * @return Removed jobs sorted by number
+     */
+    std::vector<Job> takeFinished();
+
+    /**
+     * @brief Waits for a job and removes it from the table
+     * @param id Job number
+     * @return Exit code of the job, or -1 if there is no such job
+     */
+    int wait(int id);
+
+    /**
+     * @brief Resolves a job specification
+     * @param spec `%N` (job number), `%%` or `%+` (current job) or a
+     *        process ID
+     * @return Job number, or 0 if no job matches
+     */
+    int resolve(const std::string& spec) const;
+
+    /**
+     * @brief Gets the most recently started job
+     * @return Job number, or 0 if the table is empty
+     */
+    int current() const;
+
+    /**
+     * @brief Turns reporting of started jobs on or off
+     * @param enabled true to print "[N] PID" when a job starts
+     */
+    void setNotify(bool enabled) { notify_ = enabled; }
+
+    /**
+     * @brief Checks whether started jobs are reported
+     * @return true if "[N] PID" is printed when a job starts
+     */
+    bool notify() const { return notify_; }
+
+    /**
+     * @brief Formats a job the way `jobs` lists it
+     * @param job Job to format
+     * @return Line without trailing newline, e.g. "[1]  Running\tsleep 5 &"
+     */
+    static std::string describe(const Job& job);
+
+private:
+    JobTable();
+    JobTable(const JobTable&) = delete;
+    JobTable& operator=(const JobTable&) = delete;
+
+    bool isOwner() const;
+
+    std::map<int, Job> jobs_;
+    pid_t owner_;
+    bool notify_ = false;
+};
+#endif
+
+#endif
@@ -2,12 +2,39 @@
 #define LEXER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 /**
  * @brief Type of lexical token
  */
-enum class TokenType { WORD, QUOTED_SINGLE, QUOTED_DOUBLE, ASSIGNMENT, PIPE };
+enum class TokenType {
+    WORD,
+    QUOTED_SINGLE,
+    QUOTED_DOUBLE,
+    ASSIGNMENT,
+    PIPE,
+    BACKGROUND,
+    REDIRECT  // `<`, `>`, `>>`, with an optional descriptor digit, or `N>&M`
+};
+
+/**
+ * @brief Lexical token referring to a slice of the tokenized line
+ *
+ * The line must outlive the token. The grammar has no escape sequences,
+ * so the slice (without the surrounding quotes for quoted tokens) already
+ * is the token's value and is never copied or rewritten.
+ */
+struct TokenView {
+    TokenType type;
+    std::string_view value;
+
+    /**
+     * @brief Copies token value into an owned string
+     * @return Token value
+     */
+    std::string str() const { return std::string(value); }
+};
 
 /**
  * @brief Represents a single lexical token
@@ -22,6 +49,13 @@ struct Token {
      * @param v Token value
      */
     Token(TokenType t, const std::string& v) : type(t), value(v) {}
+
+    /**
+     * @brief Constructs owning token from a token view
+     * @param view Token view to copy
+     */
+    explicit Token(const TokenView& view)
+        : type(view.type), value(view.value) {}
 };
 
 /**
@@ -36,13 +70,32 @@ public:
      */
     std::vector<Token> tokenize(const std::string& input);
 
+    /**
+     * @brief Tokenizes input without copying it
+     * @param input Line to tokenize (must outlive the returned tokens)
+     * @return Vector of token views into input
+     */
+    std::vector<TokenView> tokenizeView(std::string_view input);
+
+    /**
+     * @brief Tokenizes input into a reused vector
+     *
+     * Once tokens has grown to the largest line seen, tokenizing does not
+     * allocate at all.
+     * @param input Line to tokenize (must outlive the tokens)
+     * @param tokens Output vector, cleared first
+     */
+    void tokenizeView(std::string_view input, std::vector<TokenView>& tokens);
+
 private:
     void skipWhitespace();
-    Token readQuotedToken(char quote);
-    Token readWordToken();
-    Token readPipeToken();
+    TokenView readQuotedToken(char quote);
+    TokenView readWordToken();
+    TokenView readOperatorToken(TokenType type);
+    TokenView readRedirectToken();
+    bool atRedirect() const;
 
-    std::string input_;
+    std::string_view input_;
     size_t pos_;
 };
 
@@ -0,0 +1,114 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "source_sink.h"
+
+/**
+ * @brief Read-only input file shared by the file-reading builtins
+ *
+ * Regular files are mapped into memory and advised for sequential access,
+ * so their contents are consumed without copying through a stream buffer.
+ * Pipes, FIFOs, devices and /proc-style files (which cannot be mapped or
+ * report a size of 0) are read with buffered read() instead.
+ *
+ * A file shrinking while it is mapped (log rotation, truncate) would make
+ * touching the pages past its new end raise SIGBUS. next() checks the size
+ * before each window, and a SIGBUS handler covers the remaining race: it
+ * maps zero pages over the missing part and marks the file, which then
+ * reports "file truncated while reading" through failed(). Data already
+ * handed out may then contain those zeros, so callers must check failed()
+ * once done with it.
+ */
+class MappedFile : public Source {
+public:
+    /**
+     * @brief Size of the windows handed out by next() for mapped files
+     */
+    static constexpr size_t kBlockSize = 4 * 1024 * 1024;
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Destructor - unmaps and closes the file
+     */
+    ~MappedFile() override;
+
+    /**
+     * @brief Opens file for reading
+     * @param path File path
+     * @param errorMessage Output parameter for error description
+     * @return true if successful
+     */
+    bool open(const std::string& path, std::string& errorMessage);
+
+    /**
+     * @brief Gets next block of file contents
+     * @param data Output: pointer to block (valid until the next call)
+     * @param size Output: block size in bytes
+     * @return false at end of file or on error (see failed())
+     */
+    bool next(const char*& data, size_t& size) override;
+
+    /**
+     * @brief Checks if file contents are mapped into memory
+     * @return true if data() and size() describe the whole file
+     */
+    bool isMapped() const { return mapping_ != nullptr; }
+
+    /**
+     * @brief Gets mapped contents
+     * @return Pointer to the mapping, or nullptr if not mapped
+     */
+    const char* data() const { return mapping_; }
+
+    /**
+     * @brief Gets mapped size
+     * @return File size in bytes (0 if not mapped)
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Gets descriptor positioned at the next unread byte
+     * @return Descriptor, or -1 if not open or part of the mapping was
+     *         already handed out
+     */
+    int fd() const override { return mapping_ && offset_ > 0 ? -1 : fd_; }
+
+    /**
+     * @brief Checks if a read error occurred
+     * @return true if next() stopped because of an error
+     */
+    bool failed() const override { return failed_ || truncated(); }
+
+    /**
+     * @brief Gets description of the last read error
+     * @return Error message
+     */
+    const std::string& errorMessage() const;
+
+private:
+    void close();
+
+    /**
+     * @brief Checks if the SIGBUS handler caught a fault in the mapping
+     * @return true if the file shrank under the mapping
+     */
+    bool truncated() const;
+
+    int fd_ = -1;
+    int guard_ = -1;  // slot watched by the SIGBUS handler
+    char* mapping_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    bool failed_ = false;
+    std::string errorMessage_;
+    std::vector<char> buffer_;
+};
+
+#endif
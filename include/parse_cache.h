@@ -0,0 +1,84 @@
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "command_plan.h"
+
+/**
+ * @brief Bounded LRU cache of command plans keyed by the raw line
+ */
+class ParseCache {
+public:
+    /**
+     * @brief Number of lines kept by default
+     */
+    static constexpr size_t kDefaultCapacity = 256;
+
+    /**
+     * @brief Constructs empty cache
+     * @param capacity Maximum number of lines kept (0 disables caching)
+     */
+    explicit ParseCache(size_t capacity = kDefaultCapacity);
+
+    /**
+     * @brief Looks up a line and marks it as most recently used
+     * @param line Raw command line
+     * @return Plan, or nullptr on a miss
+     */
+    std::shared_ptr<const CommandPlan> find(std::string_view line);
+
+    /**
+     * @brief Stores a plan, evicting the least recently used line
+     * @param line Raw command line
+     * @param plan Plan compiled from line
+     */
+    void insert(std::string line, std::shared_ptr<const CommandPlan> plan);
+
+    /**
+     * @brief Removes all lines (counters are kept)
+     */
+    void clear();
+
+    /**
+     * @brief Gets number of successful lookups
+     * @return Hit count
+     */
+    size_t hits() const { return hits_; }
+
+    /**
+     * @brief Gets number of failed lookups
+     * @return Miss count
+     */
+    size_t misses() const { return misses_; }
+
+    /**
+     * @brief Gets number of cached lines
+     * @return Cache size
+     */
+    size_t size() const { return entries_.size(); }
+
+    /**
+     * @brief Gets maximum number of cached lines
+     * @return Cache capacity
+     */
+    size_t capacity() const { return capacity_; }
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const CommandPlan>>;
+
+    size_t capacity_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    // Most recently used first; index keys point into the list's strings.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+};
+
+#endif
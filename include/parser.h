@@ -4,7 +4,9 @@
 #include <memory>
 #include <vector>
 
+#include "command_plan.h"
 #include "lexer.h"
+#include "parse_cache.h"
 
 class AbstractCommand;
 class EnvironmentManager;
@@ -21,24 +23,71 @@ public:
     explicit Parser(EnvironmentManager& envManager);
 
     /**
-     * @brief Parses tokens into command object
+     * @brief Parses owning tokens into command object (see parseLine for
+     *        the copy-free path)
      * @param tokens Vector of tokens to parse
      * @return Unique pointer to command, or nullptr if no command
      */
     std::unique_ptr<AbstractCommand> parse(const std::vector<Token>& tokens);
 
+    /**
+     * @brief Parses a raw command line, reusing earlier work for it
+     *
+     * Plans are kept in an LRU cache keyed by the line and bound against
+     * the environment on every call, so a cached line sees the current
+     * variable values. A line that misses the cache is tokenized into
+     * views of the line, so no token is copied.
+     * @param line Command line
+     * @return Unique pointer to command, or nullptr if no command
+     */
+    std::unique_ptr<AbstractCommand> parseLine(const std::string& line);
+
+    /**
+     * @brief Compiles tokens into a plan without expanding variables
+     * @param tokens Token views (their line must outlive the call only;
+     *        the plan owns its text)
+     * @return Plan, or nullptr for empty input or a syntax error
+     */
+    std::shared_ptr<const CommandPlan> compile(
+        const std::vector<TokenView>& tokens);
+
+    /**
+     * @brief Gets the parse cache (for hit/miss statistics)
+     * @return Parse cache used by parseLine
+     */
+    const ParseCache& cache() const { return cache_; }
+
+    /**
+     * @brief Gets the factory creating commands for this parser
+     * @return Command factory
+     */
+    const CommandFactory& factory() const { return factory_; }
+
+    /**
+     * @brief Adds a built-in command or replaces an existing one
+     * @param name Command name
+     * @param create Function creating the command
+     * @return Identifier of the builtin
+     */
+    BuiltinId registerBuiltin(const std::string& name, BuiltinCreator create);
+
+    /**
+     * @brief Enables or disables PipelineOptimizer (on by default)
+     * @param enabled false to run every pipeline stage as written
+     */
+    void setOptimize(bool enabled) { optimize_ = enabled; }
+
 private:
-    bool isAssignment(const std::vector<Token>& tokens);
-    void handleAssignment(const std::vector<Token>& tokens);
-    std::string resolveValue(const Token& token);
+    bool isAssignment(const std::vector<TokenView>& tokens);
+    Word compileWord(const TokenView& token);
 
     /**
      * @brief Splits tokens by PIPE operator
      * @param tokens Vector of tokens to split
      * @return Vector of token groups (one per command in pipeline)
      */
-    std::vector<std::vector<Token>> splitByPipe(
-        const std::vector<Token>& tokens);
+    std::vector<std::vector<TokenView>> splitByPipe(
+        const std::vector<TokenView>& tokens);
 
     /**
      * @brief Validates pipeline structure
@@ -46,18 +95,54 @@ private:
      * @param errorMessage Output parameter for error message
      * @return true if pipeline is valid
      */
-    bool validatePipeline(const std::vector<std::vector<Token>>& commandTokens,
-                          std::string& errorMessage);
+    bool validatePipeline(
+        const std::vector<std::vector<TokenView>>& commandTokens,
+        std::string& errorMessage);
 
     /**
-     * @brief Parses a single command (no pipes)
+     * @brief Validates redirections of a single command
+     *
+     * Every file redirection needs a file name, only stdin can be read
+     * from, only stdout and stderr can be written or duplicated, and a
+     * command must be left once the redirections are removed.
      * @param tokens Tokens for a single command
-     * @return Unique pointer to command, or nullptr if invalid
+     * @param errorMessage Output parameter for error message
+     * @return true if redirections are valid
+     */
+    bool validateRedirections(const std::vector<TokenView>& tokens,
+                              std::string& errorMessage);
+
+    /**
+     * @brief Compiles a single command (no pipes)
+     * @param tokens Tokens for a single command
+     * @return Stage plan
+     */
+    StagePlan compileStage(const std::vector<TokenView>& tokens);
+
+    /**
+     * @brief Optimizes and binds plan, printing the plan that runs under
+     *        `set -o showplan`
+     *
+     * Nothing is rewritten under pipefail, where the status of every
+     * stage counts.
+     * @param plan Compiled plan
+     * @return Command ready to execute
+     */
+    std::unique_ptr<AbstractCommand> bind(const CommandPlan& plan);
+
+    /**
+     * @brief Rebuilds a command line from tokens for `jobs` listings
+     * @param tokens Tokens of the line
+     * @return Line with quotes restored
      */
-    std::unique_ptr<AbstractCommand> parseSingleCommand(
-        const std::vector<Token>& tokens);
+    static std::string jobText(const std::vector<TokenView>& tokens);
 
     EnvironmentManager& envManager_;
+    Lexer lexer_;
+    ParseCache cache_;
+    std::vector<TokenView> views_;  // reused by parseLine
+    CommandFactory factory_;
+    bool optimize_ = true;
 };
 
 #endif
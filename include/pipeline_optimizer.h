@@ -0,0 +1,104 @@
+#ifndef PIPELINE_OPTIMIZER_H
+#define PIPELINE_OPTIMIZER_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "command_plan.h"
+
+class EnvironmentSnapshot;
+
+/**
+ * @brief Rewrites pipeline stages into cheaper equivalent ones
+ *
+ * Runs when a plan is bound, since whether a rewrite is invisible depends
+ * on the files and options of that moment. Each rule looks at one stage
+ * and may fold it into its successor; the rules are tried at every
+ * position until none applies:
+ * - cat-file: `cat FILE | X` (or `cat < FILE | X`) becomes `X < FILE`
+ * - echo-text: `echo WORDS | X` becomes X reading "WORDS\n" from memory
+ * - drop-cat: `X | cat | Y` becomes `X | Y`, and `cat <<< TEXT | Y`
+ *   becomes `Y <<< TEXT` (background jobs only)
+ *
+ * A rewrite must not change what the user can observe:
+ * - the receiving stage must read the pipe, not its own redirection;
+ * - FILE must be a regular file that opens now, otherwise cat is kept to
+ *   report the error itself;
+ * - folded stages are reported with status 0 in PIPESTATUS, so only
+ *   stages sure to succeed are folded in the foreground: echo, and cat
+ *   of a file small enough to fit the pipe to X. A cat between two
+ *   stages can fail when its reader exits early, so it is only dropped
+ *   where no status is recorded;
+ * - nothing is folded under pipefail (the caller checks).
+ *
+ * Only the standard cat and echo are rewritten, never builtins replaced
+ * with CommandFactory::registerBuiltin. A stage changing interpreter
+ * state (e.g. `exit`) is never left alone in a plan, since it would then
+ * run in the interpreter instead of a child.
+ */
+class PipelineOptimizer {
+public:
+    /**
+     * @brief Constructs optimizer
+     * @param factory Factory that resolved the builtin IDs of the plans
+     */
+    explicit PipelineOptimizer(const CommandFactory& factory);
+
+    /**
+     * @brief Applies rules until none matches
+     * @param stages Stages to rewrite in place
+     * @param snapshot Variables to expand file names with
+     * @param background true for a background job (no PIPESTATUS)
+     * @return Positions in the original pipeline of the removed stages,
+     *         in increasing order
+     */
+    std::vector<size_t> optimize(std::vector<StagePlan>& stages,
+                                 const EnvironmentSnapshot& snapshot,
+                                 bool background) const;
+
+private:
+    struct Context {
+        const EnvironmentSnapshot& snapshot;
+        bool background;
+    };
+
+    struct Rule {
+        const char* name;
+        bool (PipelineOptimizer::*apply)(std::vector<StagePlan>& stages,
+                                         size_t index,
+                                         const Context& context) const;
+    };
+
+    static const std::array<Rule, 3> kRules;
+
+    bool catFile(std::vector<StagePlan>& stages, size_t index,
+                 const Context& context) const;
+    bool echoText(std::vector<StagePlan>& stages, size_t index,
+                  const Context& context) const;
+    bool dropCat(std::vector<StagePlan>& stages, size_t index,
+                 const Context& context) const;
+
+    /**
+     * @brief Checks if stage index can absorb the stage before it
+     * @param stages Pipeline stages
+     * @param index Stage that would receive the input
+     * @return true if a stage follows, reads its stdin from the pipe and
+     *         would not be left alone while changing interpreter state
+     */
+    bool canReceive(const std::vector<StagePlan>& stages, size_t index) const;
+
+    /**
+     * @brief Checks if cat of a file can be replaced with a redirection
+     * @param path File name
+     * @param context Binding context
+     * @return true for a regular readable file, small enough to fit the
+     *         pipe unless the job is in the background
+     */
+    static bool canFoldFile(const std::string& path, const Context& context);
+
+    const CommandFactory& factory_;
+};
+
+#endif
@@ -1,11 +1,11 @@
 #ifndef PROCESS_MANAGER_H
 #define PROCESS_MANAGER_H
 
-#include <iostream>
-#include <map>
 #include <string>
 #include <vector>
 
+#include "source_sink.h"
+
 #ifndef _WIN32
 #include <sys/types.h>
 #endif
@@ -19,19 +19,58 @@ public:
      * @brief Executes external program
      * @param program Program name or path
      * @param args Program arguments
-     * @param environment Environment variables to pass
-     * @param input Input stream
-     * @param output Output stream
-     * @param error Error stream
+     * @param envp Null-terminated "NAME=value" environment of the program
+     *
+     * Streams backed by a descriptor are passed to the program directly;
+     * other streams are pumped through pipes (see StreamPump). On Windows
+     * the program inherits the process standard handles.
+     * @param input Input source
+     * @param output Output sink (flushed before the program starts)
+     * @param error Error sink (flushed before the program starts)
      * @return Program exit code
      */
     int executeExternal(const std::string& program,
                         const std::vector<std::string>& args,
-                        const std::map<std::string, std::string>& environment,
-                        std::istream& input, std::ostream& output,
-                        std::ostream& error);
+                        char* const envp[], Source& input, Sink& output,
+                        Sink& error);
 
 #ifndef _WIN32
+    /**
+     * @brief Starts external program without waiting for it
+     *
+     * The executable is looked up through CommandHashTable and argv/envp
+     * are built in the parent; the child is created with posix_spawn
+     * (vfork-style on glibc), so the interpreter's memory is never copied.
+     * @param program Program name or path
+     * @param args Program arguments
+     * @param envp Null-terminated "NAME=value" environment of the program
+     * @param inFd Descriptor to use as stdin (-1 to inherit)
+     * @param outFd Descriptor to use as stdout (-1 to inherit)
+     * @param errFd Descriptor to use as stderr (-1 to inherit)
+     * @return pid_t of child process, or -1 on error (errno is set)
+     */
+    pid_t spawnProcess(const std::string& program,
+                       const std::vector<std::string>& args,
+                       char* const envp[], int inFd, int outFd,
+                       int errFd = -1);
+
+    /**
+     * @brief Spawns an already resolved executable
+     *
+     * A file the kernel cannot execute (ENOEXEC, e.g. a script without a
+     * `#!` line) is run by /bin/sh, as execvp() does.
+     * @param path Path to executable
+     * @param argv Null-terminated argument vector
+     * @param envp Null-terminated environment vector
+     * @param inFd Descriptor to use as stdin (-1 to inherit)
+     * @param outFd Descriptor to use as stdout (-1 to inherit)
+     * @param errFd Descriptor to use as stderr (-1 to inherit)
+     * @return pid_t of child process, or -1 on error (errno is set)
+     */
+    static pid_t spawnExecutable(const std::string& path, char* const argv[],
+                                 char* const envp[], int inFd, int outFd,
+                                 int errFd = -1);
+
     /**
      * @brief Forks a new child process
      * @return pid_t of child process (0 in child, >0 in parent, <0 on error)
@@ -0,0 +1,79 @@
+#ifndef PROCESS_SUPERVISOR_H
+#define PROCESS_SUPERVISOR_H
+
+#ifndef _WIN32
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "event_loop.h"
+
+/**
+ * @brief Waits for a group of child processes in the order they finish
+ *
+ * The children are watched through an EventLoop (pidfds with epoll on
+ * Linux), so each exit is reported as soon as it happens.
+ */
+class ProcessSupervisor {
+public:
+    /**
+     * @brief Called once per child as soon as it is reaped
+     *
+     * Receives the index given by add() and the exit code (128 + signal
+     * number for children killed by a signal). Returning true terminates
+     * all children still running.
+     */
+    using ExitHandler = std::function<bool(size_t index, int exitCode)>;
+
+    ProcessSupervisor();
+    ~ProcessSupervisor();
+
+    ProcessSupervisor(const ProcessSupervisor&) = delete;
+    ProcessSupervisor& operator=(const ProcessSupervisor&) = delete;
+
+    /**
+     * @brief Adds a child process to supervise
+     * @param pid Child process ID
+     * @return Index of the child, passed to the exit handler
+     */
+    size_t add(pid_t pid);
+
+    /**
+     * @brief Waits until all children are reaped
+     * @param onExit Handler called for each child in order of exit
+     */
+    void wait(const ExitHandler& onExit);
+
+    /**
+     * @brief Asks wait() to terminate all children still running
+     *
+     * Safe to call from any thread, before or during wait().
+     */
+    void requestTeardown();
+
+    /**
+     * @brief Gets loop the children are watched on
+     *
+     * Other sources registered on it are dispatched during wait().
+     * @return Event loop
+     */
+    EventLoop& loop() { return loop_; }
+
+private:
+    void terminateRunning();
+
+    EventLoop loop_;
+    std::vector<pid_t> pids_;
+    std::vector<bool> done_;
+    size_t running_ = 0;
+    bool tornDown_ = false;
+    const ExitHandler* onExit_ = nullptr;
+    std::atomic<bool> teardownRequested_{false};
+    int wakeFds_[2] = {-1, -1};
+};
+#endif
+
+#endif
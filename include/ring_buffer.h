@@ -0,0 +1,127 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "source_sink.h"
+
+/**
+ * @brief Bounded in-memory byte channel between two threads
+ *
+ * Used instead of an OS pipe between two builtin pipeline stages running
+ * in the same process. Writers block while the buffer is full, readers
+ * block while it is empty.
+ */
+class RingBuffer {
+public:
+    /**
+     * @brief Default capacity, the same as a Linux pipe
+     */
+    static constexpr size_t kDefaultCapacity = 64 * 1024;
+
+    /**
+     * @brief Constructs ring buffer
+     * @param capacity Maximum number of buffered bytes
+     */
+    explicit RingBuffer(size_t capacity = kDefaultCapacity);
+
+    /**
+     * @brief Writes all bytes, blocking while the buffer is full
+     * @param data Bytes to write
+     * @param size Number of bytes
+     * @return false if the reader has gone away
+     */
+    bool write(const char* data, size_t size);
+
+    /**
+     * @brief Reads available bytes, blocking while the buffer is empty
+     * @param data Destination buffer
+     * @param size Destination capacity
+     * @return Number of bytes read, 0 once the writer closed and the
+     *         buffer is drained
+     */
+    size_t read(char* data, size_t size);
+
+    /**
+     * @brief Signals end of data to the reader
+     */
+    void closeWriter();
+
+    /**
+     * @brief Signals that no more data will be read; unblocks the writer
+     */
+    void closeReader();
+
+private:
+    std::vector<char> buffer_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    bool writerClosed_ = false;
+    bool readerClosed_ = false;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
+
+/**
+ * @brief Source reading from a RingBuffer
+ */
+class RingSource : public Source {
+public:
+    /**
+     * @brief Constructs source over ring
+     * @param ring Ring buffer (must outlive this object)
+     */
+    explicit RingSource(RingBuffer& ring);
+
+    /**
+     * @brief Destructor - tells the writer nothing more will be read
+     */
+    ~RingSource() override;
+
+    bool next(const char*& data, size_t& size) override;
+
+    /**
+     * @brief Stops reading; a blocked writer fails instead of waiting
+     */
+    void close();
+
+private:
+    RingBuffer& ring_;
+    std::vector<char> buffer_;
+    bool closed_ = false;
+};
+
+/**
+ * @brief Sink writing to a RingBuffer
+ */
+class RingSink : public Sink {
+public:
+    /**
+     * @brief Constructs sink over ring
+     * @param ring Ring buffer (must outlive this object)
+     */
+    explicit RingSink(RingBuffer& ring);
+
+    /**
+     * @brief Destructor - signals end of data to the reader
+     */
+    ~RingSink() override;
+
+    bool write(const char* data, size_t size) override;
+    using Sink::write;
+
+    /**
+     * @brief Signals end of data to the reader
+     */
+    void close();
+
+private:
+    RingBuffer& ring_;
+    bool closed_ = false;
+};
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef SOURCE_SINK_H
+#define SOURCE_SINK_H
+
+#include <cstddef>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Byte-oriented input of a command
+ *
+ * Hands out contiguous blocks instead of characters, and exposes the
+ * underlying file descriptor when there is one so that commands can use
+ * zero-copy system calls.
+ */
+class Source {
+public:
+    /**
+     * @brief Virtual destructor
+     */
+    virtual ~Source() = default;
+
+    /**
+     * @brief Gets next block of input, blocking until one is available
+     * @param data Output: pointer to block (valid until the next call)
+     * @param size Output: block size in bytes (never 0)
+     * @return false at end of input or on error (see failed())
+     */
+    virtual bool next(const char*& data, size_t& size) = 0;
+
+    /**
+     * @brief Gets descriptor positioned at the next unread byte
+     * @return Descriptor, or -1 if the source is not backed by one
+     */
+    virtual int fd() const { return -1; }
+
+    /**
+     * @brief Checks if next() stopped because of an error
+     * @return true on read error
+     */
+    virtual bool failed() const { return false; }
+};
+
+/**
+ * @brief Byte-oriented output of a command
+ */
+class Sink {
+public:
+    /**
+     * @brief Virtual destructor
+     */
+    virtual ~Sink() = default;
+
+    /**
+     * @brief Writes bytes
+     * @param data Bytes to write
+     * @param size Number of bytes
+     * @return false on error (e.g. the reader has gone away)
+     */
+    virtual bool write(const char* data, size_t size) = 0;
+
+    /**
+     * @brief Writes text
+     * @param text Text to write
+     * @return false on error
+     */
+    bool write(std::string_view text) {
+        return write(text.data(), text.size());
+    }
+
+    /**
+     * @brief Pushes buffered bytes to the underlying channel
+     * @return false on error
+     */
+    virtual bool flush() { return true; }
+
+    /**
+     * @brief Gets descriptor behind the sink
+     *
+     * Callers writing to the descriptor directly must flush() first.
+     * @return Descriptor, or -1 if the sink is not backed by one
+     */
+    virtual int fd() const { return -1; }
+};
+
+/**
+ * @brief Source reading from a std::istream
+ */
+class StreamSource : public Source {
+public:
+    /**
+     * @brief Constructs source over stream
+     * @param stream Stream to read from (must outlive this object)
+     */
+    explicit StreamSource(std::istream& stream);
+
+    bool next(const char*& data, size_t& size) override;
+
+    /**
+     * @brief Gets wrapped stream
+     * @return Stream
+     */
+    std::istream& stream() const { return stream_; }
+
+private:
+    std::istream& stream_;
+    std::vector<char> buffer_;
+};
+
+/**
+ * @brief Sink writing to a std::ostream
+ *
+ * Reports the process stdout/stderr descriptor when the stream writes
+ * there, so kernel-side copies still apply.
+ */
+class StreamSink : public Sink {
+public:
+    /**
+     * @brief Constructs sink over stream
+     * @param stream Stream to write to (must outlive this object)
+     */
+    explicit StreamSink(std::ostream& stream);
+
+    bool write(const char* data, size_t size) override;
+    using Sink::write;
+    bool flush() override;
+    int fd() const override;
+
+private:
+    std::ostream& stream_;
+};
+
+/**
+ * @brief Source reading from a file descriptor with read()
+ */
+class FdSource : public Source {
+public:
+    /**
+     * @brief Constructs source over descriptor
+     * @param fd Descriptor to read from
+     * @param owned Close descriptor in destructor
+     */
+    explicit FdSource(int fd, bool owned = false);
+
+    /**
+     * @brief Destructor - closes owned descriptor
+     */
+    ~FdSource() override;
+
+    FdSource(const FdSource&) = delete;
+    FdSource& operator=(const FdSource&) = delete;
+
+    bool next(const char*& data, size_t& size) override;
+    int fd() const override { return fd_; }
+    bool failed() const override { return failed_; }
+
+    /**
+     * @brief Closes the descriptor early (e.g. to signal a writer)
+     */
+    void close();
+
+private:
+    int fd_;
+    bool owned_;
+    bool failed_ = false;
+    std::vector<char> buffer_;
+};
+
+/**
+ * @brief Buffered sink writing to a file descriptor with write()
+ */
+class FdSink : public Sink {
+public:
+    /**
+     * @brief Constructs sink over descriptor
+     * @param fd Descriptor to write to
+     * @param owned Close descriptor in destructor
+     */
+    explicit FdSink(int fd, bool owned = false);
+
+    /**
+     * @brief Destructor - flushes pending output, closes owned descriptor
+     */
+    ~FdSink() override;
+
+    FdSink(const FdSink&) = delete;
+    FdSink& operator=(const FdSink&) = delete;
+
+    bool write(const char* data, size_t size) override;
+    using Sink::write;
+    bool flush() override;
+    int fd() const override { return fd_; }
+
+    /**
+     * @brief Flushes and closes the descriptor early
+     */
+    void close();
+
+private:
+    bool writeAll(const char* data, size_t size);
+
+    int fd_;
+    bool owned_;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+};
+
+/**
+ * @brief Source over an in-memory string
+ */
+class StringSource : public Source {
+public:
+    /**
+     * @brief Constructs source over text
+     * @param text Text to read (copied)
+     */
+    explicit StringSource(std::string text);
+
+    bool next(const char*& data, size_t& size) override;
+
+private:
+    std::string text_;
+    bool consumed_ = false;
+};
+
+/**
+ * @brief Sink collecting output in a string
+ */
+class StringSink : public Sink {
+public:
+    bool write(const char* data, size_t size) override;
+    using Sink::write;
+
+    /**
+     * @brief Gets collected output
+     * @return Collected bytes
+     */
+    const std::string& str() const { return text_; }
+
+private:
+    std::string text_;
+};
+
+/**
+ * @brief Stream buffer reading from a Source (for std::istream users)
+ */
+class SourceStreambuf : public std::streambuf {
+public:
+    /**
+     * @brief Constructs stream buffer
+     * @param source Source to read from (must outlive this object)
+     */
+    explicit SourceStreambuf(Source& source);
+
+    /**
+     * @brief Gets wrapped source
+     * @return Source
+     */
+    Source& source() const { return source_; }
+
+protected:
+    int_type underflow() override;
+
+private:
+    Source& source_;
+};
+
+/**
+ * @brief Stream buffer writing to a Sink (for std::ostream users)
+ */
+class SinkStreambuf : public std::streambuf {
+public:
+    /**
+     * @brief Constructs stream buffer
+     * @param sink Sink to write to (must outlive this object)
+     */
+    explicit SinkStreambuf(Sink& sink);
+
+    /**
+     * @brief Destructor - flushes pending output
+     */
+    ~SinkStreambuf() override;
+
+    /**
+     * @brief Gets wrapped sink
+     * @return Sink
+     */
+    Sink& sink() const { return sink_; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize size) override;
+    int sync() override;
+
+private:
+    bool flushPutArea();
+
+    Sink& sink_;
+    std::vector<char> buffer_;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef STREAM_PUMP_H
+#define STREAM_PUMP_H
+
+#ifndef _WIN32
+#include <memory>
+#include <vector>
+
+#include "event_loop.h"
+#include "source_sink.h"
+
+/**
+ * @brief Connects child processes to a caller's sources and sinks
+ *
+ * A stream backed by a descriptor is handed to the child as is, so the
+ * kernel moves the data without any copy through the interpreter. Other
+ * streams (strings, arbitrary std::streams) get a pipe whose far end is
+ * pumped on an event loop: blocks of the source are written into the
+ * child's stdin as it drains them, and the child's output is read in
+ * FdTransfer::kBlockSize blocks into the sink. Input and output are pumped
+ * together, so a child filling its output pipe before reading all of its
+ * input cannot deadlock the interpreter.
+ *
+ * Usage: get descriptors with inputFor()/outputFor(), start the children,
+ * call start(), then run the loop until finished().
+ */
+class StreamPump {
+public:
+    /**
+     * @brief Creates pump dispatched by the given loop
+     * @param loop Loop the pipes are watched on (must outlive this object)
+     */
+    explicit StreamPump(EventLoop& loop);
+
+    /**
+     * @brief Stops watching and closes all pipes still open
+     */
+    ~StreamPump();
+
+    StreamPump(const StreamPump&) = delete;
+    StreamPump& operator=(const StreamPump&) = delete;
+
+    /**
+     * @brief Gets descriptor a child should read a source from
+     *
+     * The source's own descriptor if it has one (the process stdin for a
+     * StreamSource over std::cin), otherwise the read end of a pipe fed
+     * from the source once start() is called.
+     * @param source Source to read (must outlive the pumping)
+     * @return Descriptor, or -1 if a pipe could not be created (errno set)
+     */
+    int inputFor(Source& source);
+
+    /**
+     * @brief Gets descriptor a child should write a sink through
+     *
+     * The sink's own descriptor if it has one, otherwise the write end of
+     * a pipe drained into the sink once start() is called. The sink is
+     * flushed when the pipe reaches end of file.
+     * @param sink Sink to write (must outlive the pumping)
+     * @return Descriptor, or -1 if a pipe could not be created (errno set)
+     */
+    int outputFor(Sink& sink);
+
+    /**
+     * @brief Checks whether any stream goes through a pipe
+     * @return true if start() has something to pump
+     */
+    bool active() const { return !streams_.empty(); }
+
+    /**
+     * @brief Closes the children's pipe ends and starts pumping
+     *
+     * Call once every child holding the descriptors has been started.
+     */
+    void start();
+
+    /**
+     * @brief Checks whether all pipes reached end of file
+     * @return true once every source was fed and every sink drained
+     */
+    bool finished() const { return open_ == 0; }
+
+    /**
+     * @brief Closes every pipe without pumping (in a forked child)
+     */
+    void closeAll();
+
+private:
+    struct Stream {
+        int fd = -1;       // interpreter's end
+        int childFd = -1;  // end handed to the children
+        Source* source = nullptr;
+        Sink* sink = nullptr;
+        const char* pending = nullptr;
+        size_t pendingSize = 0;
+    };
+
+    void feed(Stream& stream);
+    void drain(Stream& stream);
+    void finish(Stream& stream);
+
+    EventLoop& loop_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+    std::vector<char> buffer_;
+    size_t open_ = 0;
+};
+#endif
+
+#endif
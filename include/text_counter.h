@@ -0,0 +1,93 @@
+#ifndef TEXT_COUNTER_H
+#define TEXT_COUNTER_H
+
+#include <cstddef>
+
+/**
+ * @brief Line, word and byte totals as reported by wc
+ */
+struct TextStats {
+    size_t lines = 0;
+    size_t words = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * @brief Block-oriented line/word/byte counter
+ *
+ * Lines are newline characters, words are transitions from whitespace
+ * (space, \t, \n, \v, \f, \r) to any other byte. Data may be fed in blocks
+ * of any size; word state is carried across calls. SSE2/AVX2 kernels are
+ * selected at runtime and give exactly the same results as the scalar one.
+ */
+class TextCounter {
+public:
+    /**
+     * @brief Counting kernel implementation
+     */
+    enum class Kernel { Scalar, SSE2, AVX2 };
+
+    /**
+     * @brief Constructs counter using the fastest kernel for this CPU
+     */
+    TextCounter();
+
+    /**
+     * @brief Constructs counter using a specific kernel
+     * @param kernel Kernel to use (must be supported, see isSupported)
+     */
+    explicit TextCounter(Kernel kernel);
+
+    /**
+     * @brief Counts a block of data
+     * @param data Pointer to block
+     * @param size Block size in bytes
+     */
+    void update(const char* data, size_t size);
+
+    /**
+     * @brief Gets totals for all data counted so far
+     * @return Accumulated statistics
+     */
+    const TextStats& stats() const { return stats_; }
+
+    /**
+     * @brief Gets kernel used by this counter
+     * @return Kernel
+     */
+    Kernel kernel() const { return kernel_; }
+
+    /**
+     * @brief Checks if kernel can run on this CPU
+     * @param kernel Kernel to check
+     * @return true if supported
+     */
+    static bool isSupported(Kernel kernel);
+
+    /**
+     * @brief Gets the fastest kernel supported by this CPU
+     * @return Kernel
+     */
+    static Kernel bestKernel();
+
+    /**
+     * @brief Counts a contiguous buffer on several threads
+     *
+     * The buffer is split into one chunk per thread; words straddling a
+     * chunk boundary are counted once, so the result equals a single
+     * update() over the whole buffer.
+     * @param data Pointer to buffer
+     * @param size Buffer size in bytes
+     * @param threads Number of worker threads (0 or 1 counts inline)
+     * @return Totals for the buffer
+     */
+    static TextStats countParallel(const char* data, size_t size,
+                                   unsigned threads);
+
+private:
+    Kernel kernel_;
+    TextStats stats_;
+    bool inWord_ = false;
+};
+
+#endif
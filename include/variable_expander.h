@@ -0,0 +1,37 @@
+#ifndef VARIABLE_EXPANDER_H
+#define VARIABLE_EXPANDER_H
+
+#include <string>
+#include <string_view>
+
+#include "command_plan.h"
+
+class EnvironmentManager;
+
+/**
+ * @brief Expands `$NAME`, `${NAME}` and `$?` references in text
+ *
+ * Text is scanned once from left to right. A `$` that does not start a
+ * reference (e.g. followed by a space, or `${` without a closing brace)
+ * is kept as is.
+ */
+class VariableExpander {
+public:
+    /**
+     * @brief Splits text into literal segments and variable slots
+     * @param text Text to scan
+     * @return Word that expands to the value of text
+     */
+    static Word compile(std::string_view text);
+
+    /**
+     * @brief Expands text with current variable values
+     * @param text Text to expand
+     * @param envManager Environment to take variable values from
+     * @return Expanded text
+     */
+    static std::string expand(std::string_view text,
+                              const EnvironmentManager& envManager);
+};
+
+#endif
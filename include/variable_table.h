@@ -0,0 +1,93 @@
+#ifndef VARIABLE_TABLE_H
+#define VARIABLE_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Open-addressing hash table of variable names and values
+ *
+ * Slots are searched with linear probing; each name is stored once, in
+ * its slot, and lookups take a string_view, so finding a variable never
+ * allocates. Variables are never removed.
+ *
+ * Copies are cheap: slots live in fixed-size chunks shared between copies
+ * and cloned by the first set() touching them, and values are shared
+ * immutable strings. A copy followed by one set() (a new environment
+ * snapshot) costs a pointer per chunk plus one chunk, whatever the size
+ * of the values.
+ */
+class VariableTable {
+public:
+    /**
+     * @brief Constructs empty table
+     */
+    VariableTable();
+
+    /**
+     * @brief Looks a variable up
+     * @param name Variable name
+     * @return Pointer to value (valid while this table or a copy holding
+     *         the same value is alive), or nullptr
+     */
+    const std::string* find(std::string_view name) const;
+
+    /**
+     * @brief Adds or replaces a variable
+     * @param name Variable name
+     * @param value Variable value
+     */
+    void set(std::string_view name, std::string_view value);
+
+    /**
+     * @brief Gets number of variables
+     * @return Variable count
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Calls f(name, value) for every variable, in no particular order
+     * @param f Callable taking two std::string_view arguments
+     */
+    template <typename F>
+    void forEach(F f) const {
+        for (const auto& chunk : chunks_) {
+            for (const auto& slot : *chunk) {
+                if (slot.used) {
+                    f(std::string_view(slot.name),
+                      std::string_view(*slot.value));
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kChunkSlots = 64;
+
+    struct Slot {
+        bool used = false;
+        uint64_t hash = 0;
+        std::string name;
+        std::shared_ptr<const std::string> value;
+    };
+    using Chunk = std::array<Slot, kChunkSlots>;
+
+    static uint64_t hashName(std::string_view name);
+    size_t findSlot(std::string_view name, uint64_t hash) const;
+    const Slot& slot(size_t index) const {
+        return (*chunks_[index / kChunkSlots])[index % kChunkSlots];
+    }
+    Slot& mutableSlot(size_t index);
+    void grow();
+
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    size_t capacity_ = 0;  // slot count, a power of two
+    size_t size_ = 0;
+};
+
+#endif
@@ -1,6 +1,23 @@
 #include "command_executor.h"
 
 #include "commands/abstract_command.h"
+#include "commands/pipeline_command.h"
+#include "environment_manager.h"
+
+namespace {
+
+// Sets $PIPESTATUS after a foreground command: every stage of a pipeline,
+// or the one status of anything else.
+int recordStatus(AbstractCommand* command, int exitCode) {
+    auto pipeline = dynamic_cast<PipelineCommand*>(command);
+    // A pipeline failing before it started its stages has no statuses.
+    bool stages = pipeline && !pipeline->stageExitCodes().empty();
+    EnvironmentManager::getInstance().setPipeStatus(
+        stages ? pipeline->stageExitCodes() : std::vector<int>{exitCode});
+    return exitCode;
+}
+
+}  // namespace
 
 int CommandExecutor::execute(AbstractCommand* command, std::istream& input,
                              std::ostream& output, std::ostream& error) {
@@ -8,5 +25,14 @@ int CommandExecutor::execute(AbstractCommand* command, std::istream& input,
         return 0;
     }
 
-    return command->execute(input, output, error);
+    return recordStatus(command, command->execute(input, output, error));
+}
+
+int CommandExecutor::execute(AbstractCommand* command, Source& input,
+                             Sink& output, Sink& error) {
+    if (!command) {
+        return 0;
+    }
+
+    return recordStatus(command, command->execute(input, output, error));
 }
@@ -1,33 +1,158 @@
 #include "command_factory.h"
 
+#include <algorithm>
+#include <array>
+
 #include "commands/abstract_command.h"
 #include "commands/cat_command.h"
 #include "commands/echo_command.h"
 #include "commands/exit_command.h"
 #include "commands/external_command.h"
+#include "commands/fg_command.h"
+#include "commands/hash_command.h"
+#include "commands/jobs_command.h"
+#include "commands/parallel_command.h"
 #include "commands/pwd_command.h"
+#include "commands/set_command.h"
+#include "commands/wait_command.h"
 #include "commands/wc_command.h"
 
+namespace {
+
+using Args = std::vector<std::string>;
+
+std::unique_ptr<AbstractCommand> createCat(const Args& args) {
+    return std::make_unique<CatCommand>(args.empty() ? "" : args[0]);
+}
+
+std::unique_ptr<AbstractCommand> createEcho(const Args& args) {
+    return std::make_unique<EchoCommand>(args);
+}
+
+std::unique_ptr<AbstractCommand> createExit(const Args&) {
+    return std::make_unique<ExitCommand>();
+}
+
+std::unique_ptr<AbstractCommand> createFg(const Args& args) {
+    return std::make_unique<FgCommand>(args);
+}
+
+std::unique_ptr<AbstractCommand> createHash(const Args& args) {
+    return std::make_unique<HashCommand>(args);
+}
+
+std::unique_ptr<AbstractCommand> createJobs(const Args&) {
+    return std::make_unique<JobsCommand>();
+}
+
+std::unique_ptr<AbstractCommand> createParallel(const Args& args) {
+    return std::make_unique<ParallelCommand>(args);
+}
+
+std::unique_ptr<AbstractCommand> createPwd(const Args&) {
+    return std::make_unique<PwdCommand>();
+}
+
+std::unique_ptr<AbstractCommand> createSet(const Args& args) {
+    return std::make_unique<SetCommand>(args);
+}
+
+std::unique_ptr<AbstractCommand> createWait(const Args& args) {
+    return std::make_unique<WaitCommand>(args);
+}
+
+std::unique_ptr<AbstractCommand> createWc(const Args& args) {
+    return std::make_unique<WcCommand>(args.empty() ? "" : args[0]);
+}
+
+struct Builtin {
+    std::string_view name;
+    BuiltinCreator create;
+};
+
+// Must stay sorted by name: lookups binary-search it.
+constexpr std::array<Builtin, 11> kBuiltins = {{
+    {"cat", &createCat},
+    {"echo", &createEcho},
+    {"exit", &createExit},
+    {"fg", &createFg},
+    {"hash", &createHash},
+    {"jobs", &createJobs},
+    {"parallel", &createParallel},
+    {"pwd", &createPwd},
+    {"set", &createSet},
+    {"wait", &createWait},
+    {"wc", &createWc},
+}};
+
+constexpr bool isSorted() {
+    for (size_t i = 1; i < kBuiltins.size(); i++) {
+        if (!(kBuiltins[i - 1].name < kBuiltins[i].name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isSorted(), "kBuiltins must be sorted by name");
+
+constexpr BuiltinId kFirstRegistered =
+    static_cast<BuiltinId>(kBuiltins.size());
+
+}  // namespace
+
 std::unique_ptr<AbstractCommand> CommandFactory::createCommand(
-    const std::string& name, const std::vector<std::string>& args) {
-    if (name == "cat") {
-        std::string filename = args.empty() ? "" : args[0];
-        return std::make_unique<CatCommand>(filename);
-    } else if (name == "wc") {
-        std::string filename = args.empty() ? "" : args[0];
-        return std::make_unique<WcCommand>(filename);
-    } else if (name == "echo") {
-        return std::make_unique<EchoCommand>(args);
-    } else if (name == "pwd") {
-        return std::make_unique<PwdCommand>();
-    } else if (name == "exit") {
-        return std::make_unique<ExitCommand>();
-    } else {
-        return std::make_unique<ExternalCommand>(name, args);
+    const std::string& name, const std::vector<std::string>& args) const {
+    return createCommand(findBuiltin(name), name, args);
+}
+
+std::unique_ptr<AbstractCommand> CommandFactory::createCommand(
+    BuiltinId builtin, const std::string& name,
+    const std::vector<std::string>& args) const {
+    if (builtin >= 0 && builtin < kFirstRegistered) {
+        return kBuiltins[builtin].create(args);
+    }
+    size_t index = static_cast<size_t>(builtin - kFirstRegistered);
+    if (builtin >= kFirstRegistered && index < registered_.size()) {
+        return registered_[index].create(args);
+    }
+    return std::make_unique<ExternalCommand>(name, args);
+}
+
+BuiltinId CommandFactory::findBuiltin(std::string_view name) const {
+    if (!registeredIds_.empty()) {
+        auto it = registeredIds_.find(name);
+        if (it != registeredIds_.end()) {
+            return it->second;
+        }
     }
+
+    return standardBuiltin(name);
 }
 
-bool CommandFactory::isBuiltinCommand(const std::string& name) const {
-    return name == "cat" || name == "wc" || name == "echo" || name == "pwd" ||
-           name == "exit";
+BuiltinId CommandFactory::standardBuiltin(std::string_view name) {
+    auto it = std::lower_bound(
+        kBuiltins.begin(), kBuiltins.end(), name,
+        [](const Builtin& builtin, std::string_view key) {
+            return builtin.name < key;
+        });
+    if (it != kBuiltins.end() && it->name == name) {
+        return static_cast<BuiltinId>(it - kBuiltins.begin());
+    }
+    return kNoBuiltin;
+}
+
+BuiltinId CommandFactory::registerBuiltin(const std::string& name,
+                                          BuiltinCreator create) {
+    auto it = registeredIds_.find(name);
+    if (it != registeredIds_.end()) {
+        registered_[it->second - kFirstRegistered].create = create;
+        return it->second;
+    }
+
+    BuiltinId id =
+        kFirstRegistered + static_cast<BuiltinId>(registered_.size());
+    registered_.push_back({name, create});
+    registeredIds_.emplace(registered_.back().name, id);
+    return id;
 }
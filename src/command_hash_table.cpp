@@ -0,0 +1,119 @@
+#include "command_hash_table.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+constexpr char kPathSeparator = ';';
+
+bool isExecutableFile(const std::string& path) {
+    return _access(path.c_str(), 0) == 0;
+}
+#else
+constexpr char kPathSeparator = ':';
+
+bool isExecutableFile(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+           access(path.c_str(), X_OK) == 0;
+}
+#endif
+
+}  // namespace
+
+CommandHashTable& CommandHashTable::getInstance() {
+    static CommandHashTable instance;
+    return instance;
+}
+
+std::string CommandHashTable::find(const std::string& program,
+                                   const std::string& searchPath) {
+    if (program.find('/') != std::string::npos) {
+        return program;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(program);
+        if (it != entries_.end()) {
+            it->second.hits++;
+            return it->second.path;
+        }
+    }
+
+    std::string path = search(program, searchPath);
+    if (!path.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[program] = Entry{program, path, 1};
+    }
+    return path;
+}
+
+bool CommandHashTable::add(const std::string& program,
+                           const std::string& searchPath) {
+    std::string path = search(program, searchPath);
+    if (path.empty() || program.find('/') != std::string::npos) {
+        return !path.empty();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[program] = Entry{program, path, 0};
+    return true;
+}
+
+void CommandHashTable::remove(const std::string& program) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(program);
+}
+
+void CommandHashTable::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+std::vector<CommandHashTable::Entry> CommandHashTable::entries() const {
+    std::vector<Entry> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [name, entry] : entries_) {
+            result.push_back(entry);
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const Entry& a, const Entry& b) { return a.name < b.name; });
+    return result;
+}
+
+std::string CommandHashTable::search(const std::string& program,
+                                     const std::string& searchPath) {
+    if (program.empty()) {
+        return "";
+    }
+    if (program.find('/') != std::string::npos) {
+        return program;
+    }
+
+    size_t begin = 0;
+    while (begin <= searchPath.size()) {
+        size_t end = searchPath.find(kPathSeparator, begin);
+        if (end == std::string::npos) {
+            end = searchPath.size();
+        }
+        // An empty PATH element means the current directory.
+        std::string dir = searchPath.substr(begin, end - begin);
+        std::string candidate = (dir.empty() ? "." : dir) + "/" + program;
+        if (isExecutableFile(candidate)) {
+            return candidate;
+        }
+        begin = end + 1;
+    }
+    return "";
+}
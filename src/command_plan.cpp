@@ -0,0 +1,233 @@
+#include "command_plan.h"
+
+#include "commands/abstract_command.h"
+#include "commands/background_command.h"
+#include "commands/pipeline_command.h"
+#include "commands/redirected_command.h"
+#include "environment_manager.h"
+
+namespace {
+
+std::unique_ptr<AbstractCommand> bindStage(
+    const StagePlan& stage, const EnvironmentSnapshot& snapshot,
+    const CommandFactory& factory) {
+    if (stage.words.empty()) {
+        return nullptr;
+    }
+
+    std::vector<std::string> args;
+    args.reserve(stage.words.size() - 1);
+    for (size_t i = 1; i < stage.words.size(); i++) {
+        args.push_back(stage.words[i].bind(snapshot));
+    }
+
+    // A name coming from a variable can only be looked up now.
+    const Word& nameWord = stage.words[0];
+    std::string name = nameWord.bind(snapshot);
+    BuiltinId builtin =
+        nameWord.isLiteral() ? stage.builtin : factory.findBuiltin(name);
+    auto command = factory.createCommand(builtin, name, args);
+    if (stage.redirects.empty() || !command) {
+        return command;
+    }
+
+    std::vector<Redirection> redirections;
+    redirections.reserve(stage.redirects.size());
+    for (const auto& redirect : stage.redirects) {
+        redirections.push_back({redirect.kind, redirect.fd,
+                                redirect.target.bind(snapshot),
+                                redirect.targetFd});
+    }
+    return std::make_unique<RedirectedCommand>(std::move(command),
+                                               std::move(redirections));
+}
+
+std::string describeRedirect(const RedirectPlan& redirect) {
+    switch (redirect.kind) {
+        case Redirection::Kind::Input:
+            return "< " + redirect.target.describe();
+        case Redirection::Kind::Output:
+            return (redirect.fd == 1 ? "> " : "2> ") +
+                   redirect.target.describe();
+        case Redirection::Kind::Append:
+            return (redirect.fd == 1 ? ">> " : "2>> ") +
+                   redirect.target.describe();
+        case Redirection::Kind::Duplicate:
+            return std::to_string(redirect.fd) + ">&" +
+                   std::to_string(redirect.targetFd);
+        case Redirection::Kind::Text:
+            return "<<< " + redirect.target.describe();
+    }
+    return "";
+}
+
+}  // namespace
+
+void Word::appendLiteral(std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    if (!segments_.empty() &&
+        segments_.back().kind == WordSegment::Kind::Literal) {
+        segments_.back().text += text;
+        return;
+    }
+    segments_.push_back({WordSegment::Kind::Literal, std::string(text)});
+}
+
+void Word::appendVariable(std::string_view name) {
+    segments_.push_back({WordSegment::Kind::Variable, std::string(name)});
+}
+
+bool Word::isLiteral() const {
+    for (const auto& segment : segments_) {
+        if (segment.kind == WordSegment::Kind::Variable) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Word::bind(const EnvironmentManager& envManager) const {
+    return bind(*envManager.snapshot());
+}
+
+std::string Word::bind(const EnvironmentSnapshot& snapshot) const {
+    if (segments_.size() == 1 &&
+        segments_[0].kind == WordSegment::Kind::Literal) {
+        return segments_[0].text;
+    }
+
+    // Look every variable up once, then copy into an exactly sized string.
+    std::vector<std::string_view> values;
+    values.reserve(segments_.size());
+    size_t size = 0;
+    for (const auto& segment : segments_) {
+        values.push_back(segment.kind == WordSegment::Kind::Literal
+                             ? std::string_view(segment.text)
+                             : snapshot.get(segment.text));
+        size += values.back().size();
+    }
+
+    std::string result;
+    result.reserve(size);
+    for (auto value : values) {
+        result += value;
+    }
+    return result;
+}
+
+std::string Word::describe() const {
+    std::string text;
+    bool plain = !segments_.empty();
+    bool hasSingleQuote = false;
+    for (const auto& segment : segments_) {
+        if (segment.kind == WordSegment::Kind::Variable) {
+            text += "${" + segment.text + "}";
+            plain = false;
+            continue;
+        }
+        text += segment.text;
+        for (char ch : segment.text) {
+            hasSingleQuote = hasSingleQuote || ch == '\'';
+            if (std::string_view(" \t'\"|&<>$").find(ch) !=
+                std::string_view::npos) {
+                plain = false;
+            }
+        }
+    }
+
+    if (plain) {
+        return text;
+    }
+    if (isLiteral() && !hasSingleQuote) {
+        return "'" + text + "'";
+    }
+    return "\"" + text + "\"";
+}
+
+std::shared_ptr<const CommandPlan> CommandPlan::assignment(std::string name,
+                                                           std::string value) {
+    std::shared_ptr<CommandPlan> plan(new CommandPlan());
+    plan->isAssignment_ = true;
+    plan->name_ = std::move(name);
+    plan->value_ = std::move(value);
+    return plan;
+}
+
+std::shared_ptr<const CommandPlan> CommandPlan::pipeline(
+    std::vector<StagePlan> stages) {
+    std::shared_ptr<CommandPlan> plan(new CommandPlan());
+    plan->stages_ = std::move(stages);
+    return plan;
+}
+
+std::shared_ptr<const CommandPlan> CommandPlan::background(
+    std::vector<StagePlan> stages, std::string text) {
+    std::shared_ptr<CommandPlan> plan(new CommandPlan());
+    plan->isBackground_ = true;
+    plan->text_ = std::move(text);
+    plan->stages_ = std::move(stages);
+    return plan;
+}
+
+std::shared_ptr<const CommandPlan> CommandPlan::rewritten(
+    std::vector<StagePlan> stages, std::vector<size_t> foldedStages) const {
+    std::shared_ptr<CommandPlan> plan(new CommandPlan(*this));
+    plan->stages_ = std::move(stages);
+    plan->foldedStages_ = std::move(foldedStages);
+    return plan;
+}
+
+std::string CommandPlan::describe() const {
+    if (isAssignment_) {
+        return name_ + "=" + value_;
+    }
+
+    std::string text;
+    for (size_t i = 0; i < stages_.size(); i++) {
+        if (i > 0) {
+            text += " | ";
+        }
+        const StagePlan& stage = stages_[i];
+        for (size_t j = 0; j < stage.words.size(); j++) {
+            text += (j > 0 ? " " : "") + stage.words[j].describe();
+        }
+        for (const auto& redirect : stage.redirects) {
+            text += " " + describeRedirect(redirect);
+        }
+    }
+    return isBackground_ ? text + " &" : text;
+}
+
+std::unique_ptr<AbstractCommand> CommandPlan::bind(
+    EnvironmentManager& envManager, const CommandFactory& factory) const {
+    if (isAssignment_) {
+        envManager.setVariable(name_, value_);
+        return nullptr;
+    }
+
+    // Every stage sees the same version, even if another thread
+    // publishes a new one meanwhile.
+    auto snapshot = envManager.snapshot();
+    std::unique_ptr<AbstractCommand> command;
+    if (stages_.size() == 1 && foldedStages_.empty()) {
+        command = bindStage(stages_[0], *snapshot, factory);
+    } else {
+        std::vector<std::unique_ptr<AbstractCommand>> commands;
+        for (const auto& stage : stages_) {
+            auto stageCommand = bindStage(stage, *snapshot, factory);
+            if (!stageCommand) {
+                return nullptr;
+            }
+            commands.push_back(std::move(stageCommand));
+        }
+        command = std::make_unique<PipelineCommand>(std::move(commands),
+                                                    foldedStages_);
+    }
+
+    if (isBackground_ && command) {
+        return std::make_unique<BackgroundCommand>(std::move(command), text_);
+    }
+    return command;
+}
@@ -0,0 +1,73 @@
+#include "commands/background_command.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "commands/external_command.h"
+#include "job_table.h"
+#include "process_manager.h"
+#endif
+
+BackgroundCommand::BackgroundCommand(std::unique_ptr<AbstractCommand> command,
+                                     std::string text)
+    : command_(std::move(command)), text_(std::move(text)) {}
+
+int BackgroundCommand::execute(Source& input, Sink& output, Sink& error) {
+#ifdef _WIN32
+    error.write("Background jobs are not supported on Windows\n");
+    return 1;
+#else
+    output.flush();
+    error.flush();
+
+    int devNull = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    pid_t pid;
+    if (auto external = dynamic_cast<ExternalCommand*>(command_.get())) {
+        pid = external->spawn(devNull, -1);
+        if (pid < 0 && errno == ENOENT) {
+            close(devNull);
+            error.write("Failed to execute: " + external->program() + "\n");
+            return 127;
+        }
+    } else {
+        ProcessManager processManager;
+        pid = processManager.forkProcess();
+        if (pid == 0) {
+            // CHILD PROCESS
+            if (devNull >= 0) {
+                dup2(devNull, STDIN_FILENO);
+            }
+            FdSource childInput(STDIN_FILENO);
+            FdSink childOutput(STDOUT_FILENO);
+            FdSink childError(STDERR_FILENO);
+            int exitCode =
+                command_->execute(childInput, childOutput, childError);
+            childOutput.flush();
+            childError.flush();
+            _exit(exitCode);
+        }
+    }
+
+    int savedErrno = errno;
+    if (devNull >= 0) {
+        close(devNull);
+    }
+    if (pid < 0) {
+        error.write(std::string("Fork failed: ") + strerror(savedErrno) +
+                    "\n");
+        return 1;
+    }
+
+    JobTable& jobs = JobTable::getInstance();
+    int id = jobs.add(pid, text_);
+    if (jobs.notify()) {
+        error.write("[" + std::to_string(id) + "] " + std::to_string(pid) +
+                    "\n");
+    }
+    return 0;
+#endif
+}
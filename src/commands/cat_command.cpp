@@ -1,32 +1,39 @@
 #include "commands/cat_command.h"
 
-#include <fstream>
+#include <cerrno>
+#include <cstring>
+
+#include "fd_transfer.h"
+#include "mapped_file.h"
 
 CatCommand::CatCommand(const std::string& filename) : filename_(filename) {}
 
-int CatCommand::execute(std::istream& input, std::ostream& output,
-                        std::ostream& error) {
+int CatCommand::execute(Source& input, Sink& output, Sink& error) {
     if (filename_.empty() || filename_ == "-") {
-        std::string line;
-        while (std::getline(input, line)) {
-            output << line << std::endl;
-        }
+        FdTransfer::copy(input, output);
         return 0;
     }
 
-    std::ifstream file(filename_);
+    MappedFile file;
+    std::string errorMessage;
 
-    if (!file.is_open()) {
-        error << "cat: " << filename_ << ": No such file or directory"
-              << std::endl;
+    if (!file.open(filename_, errorMessage)) {
+        error.write("cat: " + filename_ + ": " + errorMessage + "\n");
         return 1;
     }
 
-    std::string line;
-    while (std::getline(file, line)) {
-        output << line << std::endl;
+    // Sinks backed by a real descriptor get the kernel-side copy; anything
+    // else (string streams, ring buffers) is written straight from the
+    // mapping or the read buffer.
+    errno = 0;
+    if (!FdTransfer::copy(file, output)) {
+        std::string reason =
+            file.failed() ? file.errorMessage() : strerror(errno);
+        // A reader that went away early is not worth reporting.
+        if (errno != EPIPE) {
+            error.write("cat: " + filename_ + ": " + reason + "\n");
+        }
+        return 1;
     }
-
-    file.close();
     return 0;
 }
@@ -2,14 +2,22 @@
 
 EchoCommand::EchoCommand(const std::vector<std::string>& args) : args_(args) {}
 
-int EchoCommand::execute(std::istream& input, std::ostream& output,
-                         std::ostream& error) {
+int EchoCommand::execute(Source& input, Sink& output, Sink& error) {
+    size_t length = 1;
+    for (const auto& arg : args_) {
+        length += arg.size() + 1;
+    }
+
+    std::string line;
+    line.reserve(length);
     for (size_t i = 0; i < args_.size(); ++i) {
-        output << args_[i];
+        line += args_[i];
         if (i < args_.size() - 1) {
-            output << " ";
+            line += ' ';
         }
     }
-    output << std::endl;
+    line += '\n';
+
+    output.write(line);
     return 0;
 }
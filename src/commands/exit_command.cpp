@@ -2,8 +2,7 @@
 
 bool ExitCommand::exitFlag_ = false;
 
-int ExitCommand::execute(std::istream& input, std::ostream& output,
-                         std::ostream& error) {
+int ExitCommand::execute(Source& input, Sink& output, Sink& error) {
     exitFlag_ = true;
     return 0;
 }
@@ -7,9 +7,18 @@ ExternalCommand::ExternalCommand(const std::string& program,
                                  const std::vector<std::string>& args)
     : program_(program), args_(args) {}
 
-int ExternalCommand::execute(std::istream& input, std::ostream& output,
-                             std::ostream& error) {
+int ExternalCommand::execute(Source& input, Sink& output, Sink& error) {
     ProcessManager manager;
-    auto env = EnvironmentManager::getInstance().getAllVariables();
-    return manager.executeExternal(program_, args_, env, input, output, error);
+    auto environment = EnvironmentManager::getInstance().snapshot();
+    return manager.executeExternal(program_, args_, environment->envp(),
+                                   input, output, error);
 }
+
+#ifndef _WIN32
+pid_t ExternalCommand::spawn(int inFd, int outFd, int errFd) {
+    ProcessManager manager;
+    auto environment = EnvironmentManager::getInstance().snapshot();
+    return manager.spawnProcess(program_, args_, environment->envp(), inFd,
+                                outFd, errFd);
+}
+#endif
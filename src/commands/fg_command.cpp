@@ -0,0 +1,41 @@
+#include "commands/fg_command.h"
+
+#include <cctype>
+
+#include "job_table.h"
+
+FgCommand::FgCommand(const std::vector<std::string>& args) : args_(args) {}
+
+int FgCommand::execute(Source& input, Sink& output, Sink& error) {
+#ifdef _WIN32
+    error.write("fg: no job control\n");
+    return 1;
+#else
+    JobTable& table = JobTable::getInstance();
+
+    int id = table.current();
+    if (!args_.empty()) {
+        // Unlike wait, a bare number names a job, not a process.
+        std::string spec = args_[0];
+        if (!spec.empty() &&
+            std::isdigit(static_cast<unsigned char>(spec[0]))) {
+            spec = "%" + spec;
+        }
+        id = table.resolve(spec);
+    }
+
+    if (id == 0) {
+        error.write(args_.empty() ? "fg: no current job\n"
+                                  : "fg: " + args_[0] + ": no such job\n");
+        return 1;
+    }
+
+    for (const auto& job : table.jobs()) {
+        if (job.id == id) {
+            output.write(job.command + "\n");
+        }
+    }
+    output.flush();
+    return table.wait(id);
+#endif
+}
@@ -0,0 +1,38 @@
+#include "commands/hash_command.h"
+
+#include "command_hash_table.h"
+#include "environment_manager.h"
+
+HashCommand::HashCommand(const std::vector<std::string>& args)
+    : args_(args) {}
+
+int HashCommand::execute(Source& input, Sink& output, Sink& error) {
+    CommandHashTable& table = CommandHashTable::getInstance();
+
+    if (args_.empty()) {
+        auto entries = table.entries();
+        if (entries.empty()) {
+            output.write("hash: hash table empty\n");
+            return 0;
+        }
+        std::string listing = "hits\tcommand\n";
+        for (const auto& entry : entries) {
+            listing += std::to_string(entry.hits) + "\t" + entry.path + "\n";
+        }
+        output.write(listing);
+        return 0;
+    }
+
+    std::string searchPath(
+        EnvironmentManager::getInstance().getVariable("PATH"));
+    int exitCode = 0;
+    for (const auto& arg : args_) {
+        if (arg == "-r") {
+            table.clear();
+        } else if (!table.add(arg, searchPath)) {
+            error.write("hash: " + arg + ": not found\n");
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
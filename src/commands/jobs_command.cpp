@@ -0,0 +1,20 @@
+#include "commands/jobs_command.h"
+
+#include "job_table.h"
+
+int JobsCommand::execute(Source& input, Sink& output, Sink& error) {
+#ifdef _WIN32
+    return 0;
+#else
+    JobTable& table = JobTable::getInstance();
+    table.reapFinished();
+
+    std::string listing;
+    for (const auto& job : table.jobs()) {
+        listing += JobTable::describe(job) + "\n";
+    }
+    table.takeFinished();
+    output.write(listing);
+    return 0;
+#endif
+}
@@ -0,0 +1,258 @@
+#include "commands/parallel_command.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <unordered_map>
+
+#include "environment_manager.h"
+#include "event_loop.h"
+#include "io_redirector.h"
+#include "process_manager.h"
+#endif
+
+namespace {
+
+constexpr int kMaxFailures = 101;
+
+// Parses the N of -j: digits only, so "abc" or "-3" are not taken as 0
+// (no limit).
+bool parseLimit(const std::string& text, size_t& limit) {
+    if (text.empty() ||
+        text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    errno = 0;
+    unsigned long long value = std::strtoull(text.c_str(), nullptr, 10);
+    if (errno == ERANGE || value > SIZE_MAX) {
+        return false;
+    }
+    limit = static_cast<size_t>(value);
+    return true;
+}
+
+std::vector<std::string> readLines(Source& input) {
+    std::vector<std::string> lines;
+    std::string current;
+    const char* data;
+    size_t size;
+    while (input.next(data, size)) {
+        for (size_t i = 0; i < size; i++) {
+            if (data[i] == '\n') {
+                lines.push_back(std::move(current));
+                current.clear();
+            } else {
+                current += data[i];
+            }
+        }
+    }
+    if (!current.empty()) {
+        lines.push_back(std::move(current));
+    }
+    return lines;
+}
+
+// Replaces every {} in the template with the input; without any {} the
+// input becomes an extra last argument.
+std::vector<std::string> instantiate(const std::vector<std::string>& words,
+                                     const std::string& value) {
+    std::vector<std::string> result;
+    result.reserve(words.size() + 1);
+    bool replaced = false;
+    for (const auto& word : words) {
+        std::string arg;
+        size_t start = 0;
+        size_t pos;
+        while ((pos = word.find("{}", start)) != std::string::npos) {
+            arg.append(word, start, pos - start).append(value);
+            start = pos + 2;
+            replaced = true;
+        }
+        arg.append(word, start, std::string::npos);
+        result.push_back(std::move(arg));
+    }
+    if (!replaced) {
+        result.push_back(value);
+    }
+    return result;
+}
+
+}  // namespace
+
+ParallelCommand::ParallelCommand(const std::vector<std::string>& args)
+    : args_(args) {}
+
+int ParallelCommand::execute(Source& input, Sink& output, Sink& error) {
+#ifdef _WIN32
+    error.write("parallel: not supported on Windows\n");
+    return 1;
+#else
+    size_t limit = std::thread::hardware_concurrency();
+    bool keepOrder = false;
+
+    size_t i = 0;
+    for (; i < args_.size() && args_[i].size() > 1 && args_[i][0] == '-';
+         i++) {
+        const std::string& option = args_[i];
+        if (option == "-k") {
+            keepOrder = true;
+        } else if (option.compare(0, 2, "-j") == 0 &&
+                   (option.size() > 2 || i + 1 < args_.size())) {
+            std::string value =
+                option.size() > 2 ? option.substr(2) : args_[++i];
+            if (!parseLimit(value, limit)) {
+                error.write("parallel: " + value +
+                            ": invalid number of jobs\n");
+                return 2;
+            }
+        } else if (option == "--") {
+            i++;
+            break;
+        } else {
+            error.write("parallel: " + option + ": invalid option\n");
+            return 2;
+        }
+    }
+
+    std::vector<std::string> words;
+    for (; i < args_.size() && args_[i] != ":::"; i++) {
+        words.push_back(args_[i]);
+    }
+    if (words.empty()) {
+        error.write("parallel: missing command\n");
+        return 2;
+    }
+
+    std::vector<std::string> inputs;
+    if (i < args_.size()) {
+        inputs.assign(args_.begin() + i + 1, args_.end());
+    } else {
+        inputs = readLines(input);
+    }
+    if (limit == 0 || limit > inputs.size()) {
+        limit = inputs.size();
+    }
+
+    // A run is finished once its output reached end of file and the
+    // program was reaped, in either order.
+    struct Run {
+        std::string output;
+        bool closed = false;
+        bool exited = false;
+        int exitCode = 0;
+    };
+    std::unordered_map<size_t, Run> running;
+    std::vector<std::string> results(keepOrder ? inputs.size() : 0);
+    std::vector<bool> finished(keepOrder ? inputs.size() : 0);
+    size_t nextInput = 0;
+    size_t nextToWrite = 0;
+    int failures = 0;
+
+    auto deliver = [&](size_t index, std::string text, int exitCode) {
+        if (exitCode != 0) {
+            failures++;
+        }
+        if (!keepOrder) {
+            output.write(text);
+            return;
+        }
+        results[index] = std::move(text);
+        finished[index] = true;
+        for (; nextToWrite < inputs.size() && finished[nextToWrite];
+             nextToWrite++) {
+            output.write(results[nextToWrite]);
+            std::string().swap(results[nextToWrite]);
+        }
+    };
+
+    auto complete = [&](size_t index) {
+        Run& run = running[index];
+        if (run.closed && run.exited) {
+            deliver(index, std::move(run.output), run.exitCode);
+            running.erase(index);
+        }
+    };
+
+    // All runs see the environment as it was when parallel started.
+    auto environment = EnvironmentManager::getInstance().snapshot();
+    ProcessManager processManager;
+    EventLoop loop;
+    int devNull = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    char buffer[64 * 1024];
+    output.flush();
+    error.flush();
+
+    auto start = [&](size_t index) {
+        std::vector<std::string> argv = instantiate(words, inputs[index]);
+        std::string program = argv[0];
+        argv.erase(argv.begin());
+
+        int fds[2];
+        if (!IORedirector::openPipe(fds)) {
+            error.write(std::string("parallel: ") + strerror(errno) + "\n");
+            deliver(index, "", 1);
+            return;
+        }
+
+        pid_t pid = processManager.spawnProcess(
+            program, argv, environment->envp(), devNull, fds[1]);
+        int spawnErrno = errno;
+        close(fds[1]);
+        if (pid < 0) {
+            close(fds[0]);
+            error.write(spawnErrno == ENOENT
+                            ? "parallel: Failed to execute: " + program + "\n"
+                            : std::string("parallel: Fork failed: ") +
+                                  strerror(spawnErrno) + "\n");
+            deliver(index, "", spawnErrno == ENOENT ? 127 : 1);
+            return;
+        }
+
+        running[index];
+        int fd = fds[0];
+        loop.watch(fd, EventLoop::kReadable, [&, index, fd](uint32_t) {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                running[index].output.append(buffer, static_cast<size_t>(n));
+                return;
+            }
+            if (n < 0 && errno == EINTR) {
+                return;
+            }
+            loop.unwatch(fd);
+            close(fd);
+            running[index].closed = true;
+            complete(index);
+        });
+        loop.watchChild(pid, [&, index](int exitCode) {
+            Run& run = running[index];
+            run.exited = true;
+            run.exitCode = exitCode;
+            complete(index);
+        });
+    };
+
+    while (nextInput < inputs.size() || !running.empty()) {
+        while (running.size() < limit && nextInput < inputs.size()) {
+            start(nextInput++);
+        }
+        if (!running.empty()) {
+            loop.runOnce(-1);
+        }
+    }
+
+    if (devNull >= 0) {
+        close(devNull);
+    }
+    output.flush();
+
+    return failures > kMaxFailures ? kMaxFailures : failures;
+#endif
+}
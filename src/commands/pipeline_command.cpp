@@ -1,22 +1,126 @@
 #include "commands/pipeline_command.h"
 
+#include "environment_manager.h"
 #include "io_redirector.h"
 #include "process_manager.h"
 
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <signal.h>
+
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
 #include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "commands/builtin_command.h"
+#include "commands/external_command.h"
+#include "commands/redirected_command.h"
+#include "process_supervisor.h"
+#include "ring_buffer.h"
+#include "stream_pump.h"
+#endif
+
+#ifndef _WIN32
+namespace {
+
+enum class StageKind {
+    Thread,  // builtin run on a thread inside the interpreter
+    Spawn,   // external program exec'd directly
+    Fork     // any other command, run in a forked copy of the interpreter
+};
+
+// Command a stage runs, looking through its redirections.
+AbstractCommand* stageCommand(AbstractCommand* command) {
+    if (auto redirected = dynamic_cast<RedirectedCommand*>(command)) {
+        return &redirected->command();
+    }
+    return command;
+}
+
+// Gives a spawned stage the descriptors of its redirections; text is fed
+// into a pipe by the pump.
+bool applyRedirections(const RedirectedCommand& command,
+                       IORedirector& redirector, StreamPump& pump,
+                       std::vector<std::unique_ptr<StringSource>>& texts,
+                       std::array<int, 3>& fds, std::string& errorMessage) {
+    for (const auto& redirection : command.redirections()) {
+        if (redirection.kind != Redirection::Kind::Text) {
+            if (!redirector.apply(redirection, fds, errorMessage)) {
+                return false;
+            }
+            continue;
+        }
+        texts.push_back(
+            std::make_unique<StringSource>(redirection.target + "\n"));
+        fds[0] = pump.inputFor(*texts.back());
+        if (fds[0] < 0) {
+            errorMessage =
+                std::string("Failed to create pipes: ") + strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Error stream shared by the stages of a pipeline. Each write (a whole
+// message) goes out at once, so diagnostics appear as they happen and do
+// not interleave.
+class SharedErrorSink : public Sink {
+public:
+    explicit SharedErrorSink(Sink& sink) : sink_(sink) {}
+
+    bool write(const char* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sink_.write(data, size) && sink_.flush();
+    }
+    using Sink::write;
+
+    int fd() const override { return sink_.fd(); }
+
+private:
+    Sink& sink_;
+    std::mutex mutex_;
+};
+
+StageKind stageKind(AbstractCommand* command) {
+    command = stageCommand(command);
+    if (auto builtin = dynamic_cast<BuiltinCommand*>(command)) {
+        return builtin->modifiesInterpreterState() ? StageKind::Fork
+                                                   : StageKind::Thread;
+    }
+    if (dynamic_cast<ExternalCommand*>(command)) {
+        return StageKind::Spawn;
+    }
+    return StageKind::Fork;
+}
+
+// A builtin writing into a pipe whose reader exited must see EPIPE instead
+// of the whole interpreter being killed by SIGPIPE.
+void blockSigpipe() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+}  // namespace
 #endif
 
 PipelineCommand::PipelineCommand(
-    std::vector<std::unique_ptr<AbstractCommand>> commands)
-    : commands_(std::move(commands)) {}
+    std::vector<std::unique_ptr<AbstractCommand>> commands,
+    std::vector<size_t> foldedStages)
+    : commands_(std::move(commands)),
+      foldedStages_(std::move(foldedStages)) {}
 
-int PipelineCommand::execute(std::istream& input, std::ostream& output,
-                             std::ostream& error) {
+int PipelineCommand::execute(Source& input, Sink& output, Sink& error) {
 #ifdef _WIN32
-    error << "Pipelines are not supported on Windows" << std::endl;
+    error.write("Pipelines are not supported on Windows\n");
     return 1;
 #else
     if (commands_.empty()) {
@@ -24,53 +128,270 @@ int PipelineCommand::execute(std::istream& input, std::ostream& output,
     }
 
     if (commands_.size() == 1) {
-        return commands_[0]->execute(input, output, error);
+        int exitCode = commands_[0]->execute(input, output, error);
+        recordStages({exitCode});
+        return exitCode;
     }
 
     int n = commands_.size();
 
+    std::vector<StageKind> kinds;
+    for (const auto& command : commands_) {
+        kinds.push_back(stageKind(command.get()));
+    }
+
+    // Neighbouring builtin threads talk through ring buffers; every link
+    // touching a process gets a real pipe.
+    std::vector<bool> needsPipe(n - 1);
+    std::vector<std::unique_ptr<RingBuffer>> rings(n - 1);
+    for (int i = 0; i < n - 1; i++) {
+        if (kinds[i] == StageKind::Thread &&
+            kinds[i + 1] == StageKind::Thread) {
+            rings[i] = std::make_unique<RingBuffer>();
+        } else {
+            needsPipe[i] = true;
+        }
+    }
+
     IORedirector redirector;
-    if (!redirector.createPipes(n - 1)) {
-        error << "Failed to create pipes: " << strerror(errno) << std::endl;
+    if (!redirector.createPipes(needsPipe)) {
+        error.write(std::string("Failed to create pipes: ") +
+                    strerror(errno) + "\n");
         return 1;
     }
 
     ProcessManager processManager;
+    ProcessSupervisor supervisor;
     std::vector<pid_t> pids;
+    std::vector<int> pidStages;
+    std::vector<int> exitCodes(n, 1);
+
+    // Under pipefail the first failing stage tears the pipeline down and
+    // its status becomes the pipeline's.
+    bool pipefail = EnvironmentManager::getInstance().pipefail();
+    std::atomic<int> firstFailed{-1};
+    auto stageFinished = [&](int stage, int exitCode) {
+        exitCodes[stage] = exitCode;
+        int none = -1;
+        return pipefail && exitCode != 0 &&
+               firstFailed.compare_exchange_strong(none, stage);
+    };
 
+    // Processes at the ends of the pipeline use the caller's streams, and
+    // all of them write errors to the caller's error stream.
+    SharedErrorSink sharedError(error);
+    std::vector<std::unique_ptr<StringSource>> texts;
+    StreamPump pump(supervisor.loop());
+    int firstIn = STDIN_FILENO;
+    int lastOut = STDOUT_FILENO;
+    int errFd = STDERR_FILENO;
+    if (kinds[0] != StageKind::Thread) {
+        firstIn = pump.inputFor(input);
+    }
+    if (kinds[n - 1] != StageKind::Thread) {
+        lastOut = pump.outputFor(output);
+    }
+    for (StageKind kind : kinds) {
+        if (kind != StageKind::Thread) {
+            errFd = pump.outputFor(sharedError);
+            break;
+        }
+    }
+    if (firstIn < 0 || lastOut < 0 || errFd < 0) {
+        error.write(std::string("Failed to create pipes: ") +
+                    strerror(errno) + "\n");
+        return 1;
+    }
+
+    output.flush();
+    error.flush();
+
+    // All processes are started before any thread, so no fork happens
+    // while a builtin stage holds a lock.
     for (int i = 0; i < n; i++) {
-        pid_t pid = processManager.forkProcess();
+        if (kinds[i] == StageKind::Thread) {
+            continue;
+        }
+
+        pid_t pid;
+        if (kinds[i] == StageKind::Spawn) {
+            auto external = static_cast<ExternalCommand*>(
+                stageCommand(commands_[i].get()));
+            std::array<int, 3> fds = {
+                i > 0 ? redirector.readEnd(i - 1) : firstIn,
+                i < n - 1 ? redirector.writeEnd(i) : lastOut, errFd};
+
+            // Redirections only change which descriptors the child gets.
+            auto redirected =
+                dynamic_cast<RedirectedCommand*>(commands_[i].get());
+            std::string message;
+            if (redirected &&
+                !applyRedirections(*redirected, redirector, pump, texts, fds,
+                                   message)) {
+                error.write(message + "\n");
+                if (stageFinished(i, 1)) {
+                    supervisor.requestTeardown();
+                }
+                continue;
+            }
+            pid = external->spawn(fds[0], fds[1], fds[2]);
+            if (pid < 0 && errno == ENOENT) {
+                // Like a shell, a missing program fails only its own stage;
+                // its neighbours see a closed pipe.
+                error.write("Failed to execute: " + external->program() +
+                            "\n");
+                if (stageFinished(i, 127)) {
+                    supervisor.requestTeardown();
+                }
+                continue;
+            }
+        } else {
+            pid = processManager.forkProcess();
+            if (pid == 0) {
+                // CHILD PROCESS
+                redirector.setupChildPipes(i, n);
+                if (i == 0) {
+                    dup2(firstIn, STDIN_FILENO);
+                }
+                if (i == n - 1) {
+                    dup2(lastOut, STDOUT_FILENO);
+                }
+                dup2(errFd, STDERR_FILENO);
+                redirector.closeAllPipes();
+                pump.closeAll();
+
+                FdSource childInput(STDIN_FILENO);
+                FdSink childOutput(STDOUT_FILENO);
+                FdSink childError(STDERR_FILENO);
+                int exitCode =
+                    commands_[i]->execute(childInput, childOutput, childError);
+                childOutput.flush();
+                childError.flush();
+                _exit(exitCode);
+            }
+        }
 
         if (pid < 0) {
-            error << "Fork failed: " << strerror(errno) << std::endl;
+            error.write(std::string("Fork failed: ") + strerror(errno) +
+                        "\n");
             for (pid_t p : pids) {
                 processManager.terminateProcess(p);
             }
+            std::vector<int> ignored;
+            processManager.waitForProcesses(pids, ignored);
             return 1;
         }
 
-        if (pid == 0) {
-            // CHILD PROCESS
+        // PARENT PROCESS
+        pids.push_back(pid);
+        pidStages.push_back(i);
+        supervisor.add(pid);
+    }
 
-            redirector.setupChildPipes(i, n);
+    // Pipe ends used by processes are no longer needed here; the ends of
+    // builtin stages are handed over to their threads.
+    std::vector<int> threadIn(n, -1);
+    std::vector<int> threadOut(n, -1);
+    for (int i = 0; i < n - 1; i++) {
+        if (!needsPipe[i]) {
+            continue;
+        }
+        int writeFd = redirector.releaseWriteEnd(i);
+        int readFd = redirector.releaseReadEnd(i);
+        if (kinds[i] == StageKind::Thread) {
+            threadOut[i] = writeFd;
+        } else {
+            close(writeFd);
+        }
+        if (kinds[i + 1] == StageKind::Thread) {
+            threadIn[i + 1] = readFd;
+        } else {
+            close(readFd);
+        }
+    }
+    pump.start();
 
-            redirector.closeAllPipes();
+    std::vector<std::thread> threads;
 
-            int exitCode =
-                commands_[i]->execute(std::cin, std::cout, std::cerr);
-            exit(exitCode);
+    for (int i = 0; i < n; i++) {
+        if (kinds[i] != StageKind::Thread) {
+            continue;
         }
 
-        // PARENT PROCESS
-        pids.push_back(pid);
+        threads.emplace_back([&, i] {
+            blockSigpipe();
+
+            std::unique_ptr<Source> ownedInput;
+            if (threadIn[i] >= 0) {
+                ownedInput = std::make_unique<FdSource>(threadIn[i], true);
+            } else if (i > 0) {
+                ownedInput = std::make_unique<RingSource>(*rings[i - 1]);
+            }
+
+            std::unique_ptr<Sink> ownedOutput;
+            if (threadOut[i] >= 0) {
+                ownedOutput = std::make_unique<FdSink>(threadOut[i], true);
+            } else if (i < n - 1) {
+                ownedOutput = std::make_unique<RingSink>(*rings[i]);
+            }
+
+            Source& stageInput = ownedInput ? *ownedInput : input;
+            Sink& stageOutput = ownedOutput ? *ownedOutput : output;
+
+            int exitCode;
+            try {
+                exitCode = commands_[i]->execute(stageInput, stageOutput,
+                                                 sharedError);
+            } catch (...) {
+                exitCode = 1;
+            }
+            stageOutput.flush();
+
+            // Destroying the owned ends closes them, so the neighbours can
+            // finish: the reader sees end of input, the writer stops
+            // blocking on a full buffer.
+            ownedOutput.reset();
+            ownedInput.reset();
+
+            if (stageFinished(i, exitCode)) {
+                supervisor.requestTeardown();
+            }
+        });
     }
 
-    redirector.closeAllPipes();
+    // Processes are reaped in the order they exit while the builtin
+    // threads run. Teardown terminates the remaining processes; builtin
+    // threads stop once the pipes around them are closed.
+    supervisor.wait([&](size_t index, int exitCode) {
+        return stageFinished(pidStages[index], exitCode);
+    });
+    while (!pump.finished()) {
+        supervisor.loop().runOnce(-1);
+    }
 
-    std::vector<int> exitCodes;
-    processManager.waitForProcesses(pids, exitCodes);
+    for (auto& thread : threads) {
+        thread.join();
+    }
 
+    recordStages(exitCodes);
+
+    if (firstFailed >= 0) {
+        return exitCodes[firstFailed];
+    }
     // Return exit code of the last command
     return exitCodes[n - 1];
 #endif
 }
+
+void PipelineCommand::recordStages(const std::vector<int>& exitCodes) {
+    stageExitCodes_.clear();
+    auto folded = foldedStages_.begin();
+    for (int exitCode : exitCodes) {
+        while (folded != foldedStages_.end() &&
+               *folded == stageExitCodes_.size()) {
+            stageExitCodes_.push_back(0);
+            ++folded;
+        }
+        stageExitCodes_.push_back(exitCode);
+    }
+}
@@ -1,5 +1,7 @@
 #include "commands/pwd_command.h"
 
+#include <string>
+
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -7,22 +9,21 @@
 #include <unistd.h>
 #endif
 
-int PwdCommand::execute(std::istream& input, std::ostream& output,
-                        std::ostream& error) {
+int PwdCommand::execute(Source& input, Sink& output, Sink& error) {
 #ifdef _WIN32
     char buffer[MAX_PATH];
     if (GetCurrentDirectoryA(MAX_PATH, buffer)) {
-        output << buffer << std::endl;
+        output.write(std::string(buffer) + "\n");
         return 0;
     }
 #else
     char buffer[PATH_MAX];
     if (getcwd(buffer, sizeof(buffer))) {
-        output << buffer << std::endl;
+        output.write(std::string(buffer) + "\n");
         return 0;
     }
 #endif
 
-    error << "pwd: failed to get current directory" << std::endl;
+    error.write("pwd: failed to get current directory\n");
     return 1;
 }
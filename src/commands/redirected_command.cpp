@@ -0,0 +1,48 @@
+#include "commands/redirected_command.h"
+
+#include <cerrno>
+#include <cstring>
+
+RedirectedCommand::RedirectedCommand(std::unique_ptr<AbstractCommand> command,
+                                     std::vector<Redirection> redirections)
+    : command_(std::move(command)), redirections_(std::move(redirections)) {}
+
+int RedirectedCommand::execute(Source& input, Sink& output, Sink& error) {
+    // Declared before the streams over its files, so that the sinks are
+    // flushed before the descriptors are closed.
+    IORedirector redirector;
+    std::vector<std::unique_ptr<Source>> sources;
+    std::vector<std::unique_ptr<FdSink>> sinks;
+
+    Source* in = &input;
+    Sink* outs[3] = {nullptr, &output, &error};
+
+    for (const auto& redirection : redirections_) {
+        if (redirection.kind == Redirection::Kind::Duplicate) {
+            outs[redirection.fd] = outs[redirection.targetFd];
+            continue;
+        }
+        if (redirection.kind == Redirection::Kind::Text) {
+            sources.push_back(
+                std::make_unique<StringSource>(redirection.target + "\n"));
+            in = sources.back().get();
+            continue;
+        }
+
+        int fd = redirector.openFile(redirection);
+        if (fd < 0) {
+            outs[2]->write(redirection.target + ": " + std::strerror(errno) +
+                           "\n");
+            return 1;
+        }
+        if (redirection.fd == 0) {
+            sources.push_back(std::make_unique<FdSource>(fd));
+            in = sources.back().get();
+        } else {
+            sinks.push_back(std::make_unique<FdSink>(fd));
+            outs[redirection.fd] = sinks.back().get();
+        }
+    }
+
+    return command_->execute(*in, *outs[1], *outs[2]);
+}
@@ -0,0 +1,69 @@
+#include "commands/set_command.h"
+
+#include "environment_manager.h"
+
+namespace {
+
+struct Option {
+    const char* name;
+    bool (EnvironmentManager::*get)() const;
+    void (EnvironmentManager::*set)(bool enabled);
+};
+
+constexpr Option kOptions[] = {
+    {"pipefail", &EnvironmentManager::pipefail,
+     &EnvironmentManager::setPipefail},
+    {"showplan", &EnvironmentManager::showPlan,
+     &EnvironmentManager::setShowPlan},
+};
+
+}  // namespace
+
+SetCommand::SetCommand(const std::vector<std::string>& args) : args_(args) {}
+
+int SetCommand::execute(Source& input, Sink& output, Sink& error) {
+    EnvironmentManager& envManager = EnvironmentManager::getInstance();
+
+    if (args_.empty()) {
+        std::string listing;
+        for (const auto& [name, value] : envManager.getAllVariables()) {
+            listing += name + "=" + value + "\n";
+        }
+        output.write(listing);
+        return 0;
+    }
+
+    int exitCode = 0;
+    for (size_t i = 0; i < args_.size(); i++) {
+        const std::string& flag = args_[i];
+        if (flag != "-o" && flag != "+o") {
+            error.write("set: " + flag + ": invalid option\n");
+            return 1;
+        }
+
+        if (i + 1 == args_.size()) {
+            std::string listing;
+            for (const auto& option : kOptions) {
+                listing += std::string(option.name) + "\t" +
+                           ((envManager.*option.get)() ? "on" : "off") + "\n";
+            }
+            output.write(listing);
+            break;
+        }
+
+        const std::string& name = args_[++i];
+        const Option* option = nullptr;
+        for (const auto& candidate : kOptions) {
+            if (name == candidate.name) {
+                option = &candidate;
+            }
+        }
+        if (option) {
+            (envManager.*option->set)(flag == "-o");
+        } else {
+            error.write("set: " + name + ": invalid option name\n");
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
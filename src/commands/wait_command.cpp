@@ -0,0 +1,33 @@
+#include "commands/wait_command.h"
+
+#include "job_table.h"
+
+WaitCommand::WaitCommand(const std::vector<std::string>& args)
+    : args_(args) {}
+
+int WaitCommand::execute(Source& input, Sink& output, Sink& error) {
+#ifdef _WIN32
+    return 0;
+#else
+    JobTable& table = JobTable::getInstance();
+
+    if (args_.empty()) {
+        for (const auto& job : table.jobs()) {
+            table.wait(job.id);
+        }
+        return 0;
+    }
+
+    int exitCode = 0;
+    for (const auto& spec : args_) {
+        int id = table.resolve(spec);
+        if (id == 0) {
+            error.write("wait: " + spec + ": no such job\n");
+            exitCode = 127;
+            continue;
+        }
+        exitCode = table.wait(id);
+    }
+    return exitCode;
+#endif
+}
@@ -1,53 +1,101 @@
 #include "commands/wc_command.h"
 
-#include <fstream>
-#include <sstream>
+#include <thread>
+
+#include "mapped_file.h"
+#include "text_counter.h"
+
+namespace {
+
+// Smallest slice worth a thread of its own.
+constexpr size_t kMinChunkSize = 16 * 1024 * 1024;
+
+}  // namespace
+
+std::atomic<size_t> WcCommand::parallelThreshold_{64 * 1024 * 1024};
+std::atomic<unsigned> WcCommand::maxThreads_{0};
 
 WcCommand::WcCommand(const std::string& filename) : filename_(filename) {}
 
-int WcCommand::execute(std::istream& input, std::ostream& output,
-                       std::ostream& error) {
+int WcCommand::execute(Source& input, Sink& output, Sink& error) {
     size_t lines = 0;
     size_t words = 0;
     size_t bytes = 0;
 
     if (filename_.empty() || filename_ == "-") {
-        countFromStream(input, lines, words, bytes);
-        output << lines << " " << words << " " << bytes << std::endl;
+        if (!countFromSource(input, lines, words, bytes)) {
+            error.write("wc: read error\n");
+            return 1;
+        }
+        output.write(std::to_string(lines) + " " + std::to_string(words) +
+                     " " + std::to_string(bytes) + "\n");
         return 0;
     }
 
-    std::ifstream file(filename_);
+    MappedFile file;
+    std::string errorMessage;
 
-    if (!file.is_open()) {
-        error << "wc: " << filename_ << ": No such file or directory"
-              << std::endl;
+    if (!file.open(filename_, errorMessage)) {
+        error.write("wc: " + filename_ + ": " + errorMessage + "\n");
         return 1;
     }
 
-    countFromStream(file, lines, words, bytes);
-    output << lines << " " << words << " " << bytes << " " << filename_
-           << std::endl;
+    if (!countFromFile(file, lines, words, bytes)) {
+        error.write("wc: " + filename_ + ": " + file.errorMessage() + "\n");
+        return 1;
+    }
 
-    file.close();
+    output.write(std::to_string(lines) + " " + std::to_string(words) + " " +
+                 std::to_string(bytes) + " " + filename_ + "\n");
     return 0;
 }
 
-void WcCommand::countFromStream(std::istream& stream, size_t& lines,
-                                size_t& words, size_t& bytes) {
-    lines = 0;
-    words = 0;
-    bytes = 0;
-
-    std::string line;
-    while (std::getline(stream, line)) {
-        lines++;
-        bytes += line.length() + 1;
-
-        std::istringstream iss(line);
-        std::string word;
-        while (iss >> word) {
-            words++;
-        }
+void WcCommand::setParallelThreshold(size_t bytes) {
+    parallelThreshold_.store(bytes, std::memory_order_relaxed);
+}
+
+size_t WcCommand::parallelThreshold() {
+    return parallelThreshold_.load(std::memory_order_relaxed);
+}
+
+void WcCommand::setMaxThreads(unsigned threads) {
+    maxThreads_.store(threads, std::memory_order_relaxed);
+}
+
+bool WcCommand::countFromSource(Source& source, size_t& lines, size_t& words,
+                                size_t& bytes) {
+    TextCounter counter;
+    const char* data;
+    size_t size;
+    while (source.next(data, size)) {
+        counter.update(data, size);
     }
+
+    lines = counter.stats().lines;
+    words = counter.stats().words;
+    bytes = counter.stats().bytes;
+    return !source.failed();
+}
+
+bool WcCommand::countFromFile(MappedFile& file, size_t& lines, size_t& words,
+                              size_t& bytes) {
+    if (!file.isMapped() || file.size() < parallelThreshold()) {
+        return countFromSource(file, lines, words, bytes);
+    }
+
+    unsigned threads = maxThreads_.load(std::memory_order_relaxed);
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    size_t byChunks = file.size() / kMinChunkSize;
+    if (byChunks < threads) {
+        threads = static_cast<unsigned>(byChunks);
+    }
+
+    TextStats stats =
+        TextCounter::countParallel(file.data(), file.size(), threads);
+    lines = stats.lines;
+    words = stats.words;
+    bytes = stats.bytes;
+    return !file.failed();
 }
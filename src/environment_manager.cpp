@@ -1,32 +1,210 @@
 #include "environment_manager.h"
 
+#include <array>
 #include <cstdlib>
+#include <cstring>
+
+#include "command_hash_table.h"
+
+#ifdef _WIN32
+#define environ _environ
+#else
+extern char** environ;
+#endif
+
+namespace {
+
+// Snapshot last seen by this thread. It keeps that version alive, so
+// views handed out from it stay valid until the thread sees a newer one.
+struct CachedSnapshot {
+    uint64_t version = UINT64_MAX;
+    std::shared_ptr<const EnvironmentSnapshot> snapshot;
+};
+
+thread_local CachedSnapshot cachedSnapshot;
+
+// Text of an exit code for `$?`. The strings are never freed or changed,
+// so views of them stay valid however often `$?` is asked for again.
+std::string_view exitCodeText(int code) {
+    static const std::array<std::string, 256> common = [] {
+        std::array<std::string, 256> texts;
+        for (size_t i = 0; i < texts.size(); i++) {
+            texts[i] = std::to_string(i);
+        }
+        return texts;
+    }();
+    if (code >= 0 && code < static_cast<int>(common.size())) {
+        return common[static_cast<size_t>(code)];
+    }
+
+    static std::mutex mutex;
+    static std::map<int, std::string> others;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = others.find(code);
+    if (it == others.end()) {
+        it = others.emplace(code, std::to_string(code)).first;
+    }
+    return it->second;
+}
+
+}  // namespace
+
+EnvironmentSnapshot::EnvironmentSnapshot(VariableTable variables,
+                                         std::string pipeStatus,
+                                         uint64_t version,
+                                         const std::atomic<int>& exitCode)
+    : exported_(std::make_shared<Exported>()),
+      pipeStatus_(std::move(pipeStatus)),
+      version_(version),
+      exitCode_(exitCode) {
+    exported_->variables = std::move(variables);
+}
+
+EnvironmentSnapshot::EnvironmentSnapshot(const EnvironmentSnapshot& previous,
+                                         std::string pipeStatus,
+                                         uint64_t version)
+    : exported_(previous.exported_),
+      pipeStatus_(std::move(pipeStatus)),
+      version_(version),
+      exitCode_(previous.exitCode_) {}
+
+std::string_view EnvironmentSnapshot::get(std::string_view name) const {
+    if (name == "?") {
+        return exitCodeText(exitCode_.load(std::memory_order_relaxed));
+    }
+    if (name == "PIPESTATUS") {
+        return pipeStatus_;
+    }
+
+    const std::string* value = exported_->variables.find(name);
+    return value ? std::string_view(*value) : std::string_view();
+}
+
+bool EnvironmentSnapshot::has(std::string_view name) const {
+    return name == "?" || name == "PIPESTATUS" ||
+           exported_->variables.find(name) != nullptr;
+}
+
+char* const* EnvironmentSnapshot::envp() const {
+    Exported& exported = *exported_;
+    std::call_once(exported.envpOnce, [&exported] {
+        exported.envStrings.reserve(exported.variables.size());
+        exported.variables.forEach(
+            [&](std::string_view name, std::string_view value) {
+                std::string entry;
+                entry.reserve(name.size() + value.size() + 1);
+                entry.append(name).append("=").append(value);
+                exported.envStrings.push_back(std::move(entry));
+            });
+
+        exported.envp.reserve(exported.envStrings.size() + 1);
+        for (auto& entry : exported.envStrings) {
+            exported.envp.push_back(entry.data());
+        }
+        exported.envp.push_back(nullptr);
+    });
+    return exported.envp.data();
+}
 
 EnvironmentManager& EnvironmentManager::getInstance() {
     static EnvironmentManager instance;
     return instance;
 }
 
-void EnvironmentManager::setVariable(const std::string& name,
-                                     const std::string& value) {
-    variables_[name] = value;
+EnvironmentManager::EnvironmentManager() {
+    VariableTable variables;
+    for (char** env = environ; env && *env; ++env) {
+        std::string_view entry(*env);
+        size_t eq = entry.find('=');
+        if (eq != std::string_view::npos && eq > 0) {
+            variables.set(entry.substr(0, eq), entry.substr(eq + 1));
+        }
+    }
+    current_ = std::make_shared<const EnvironmentSnapshot>(
+        std::move(variables), "", 0, exitCode_);
 }
 
-std::string EnvironmentManager::getVariable(const std::string& name) const {
-    auto it = variables_.find(name);
-    if (it != variables_.end()) {
-        return it->second;
+void EnvironmentManager::setVariable(std::string_view name,
+                                     std::string_view value) {
+    if (name == "?") {
+        setExitCode(std::atoi(std::string(value).c_str()));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        auto current = std::atomic_load(&current_);
+        uint64_t version = current->version() + 1;
+        if (name == "PIPESTATUS") {
+            publish(std::make_shared<const EnvironmentSnapshot>(
+                *current, std::string(value), version));
+            return;
+        }
+
+        // Shares all but the changed chunk and value with the current one.
+        VariableTable variables = current->variables();
+        variables.set(name, value);
+        publish(std::make_shared<const EnvironmentSnapshot>(
+            std::move(variables), current->pipeStatus(), version, exitCode_));
     }
 
-    const char* envValue = std::getenv(name.c_str());
-    return envValue ? std::string(envValue) : "";
+    // Remembered command locations may not be valid for the new search path.
+    if (name == "PATH") {
+        CommandHashTable::getInstance().clear();
+    }
+}
+
+std::string_view EnvironmentManager::getVariable(std::string_view name) const {
+    return snapshot()->get(name);
 }
 
-bool EnvironmentManager::hasVariable(const std::string& name) const {
-    return variables_.find(name) != variables_.end() ||
-           std::getenv(name.c_str()) != nullptr;
+bool EnvironmentManager::hasVariable(std::string_view name) const {
+    return snapshot()->has(name);
 }
 
 std::map<std::string, std::string> EnvironmentManager::getAllVariables() const {
-    return variables_;
+    std::map<std::string, std::string> result;
+    snapshot()->variables().forEach(
+        [&](std::string_view name, std::string_view value) {
+            result.emplace(name, value);
+        });
+    return result;
+}
+
+void EnvironmentManager::setExitCode(int code) {
+    exitCode_.store(code, std::memory_order_relaxed);
 }
+
+void EnvironmentManager::setPipeStatus(const std::vector<int>& statuses) {
+    std::string text;
+    for (size_t i = 0; i < statuses.size(); i++) {
+        text += (i ? " " : "") + std::to_string(statuses[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    auto current = std::atomic_load(&current_);
+    if (current->pipeStatus() == text) {
+        return;
+    }
+    publish(std::make_shared<const EnvironmentSnapshot>(
+        *current, std::move(text), current->version() + 1));
+}
+
+void EnvironmentManager::publish(
+    std::shared_ptr<const EnvironmentSnapshot> snapshot) {
+    uint64_t version = snapshot->version();
+    std::atomic_store(&current_, std::move(snapshot));
+    version_.store(version, std::memory_order_release);
+}
+
+std::shared_ptr<const EnvironmentSnapshot> EnvironmentManager::snapshot()
+    const {
+    CachedSnapshot& cached = cachedSnapshot;
+    if (cached.version != version_.load(std::memory_order_acquire)) {
+        cached.snapshot = std::atomic_load(&current_);
+        cached.version = cached.snapshot->version();
+    }
+    return cached.snapshot;
+}
+
+char* const* EnvironmentManager::envp() const { return snapshot()->envp(); }
@@ -0,0 +1,310 @@
+#include "event_loop.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+constexpr int kMaxPollDelayMs = 16;
+
+int openPidfd(pid_t pid) {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    // pidfds are always opened close-on-exec.
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int exitCodeOf(int status) {
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return 1;
+}
+
+// Returns false if the child is still running.
+bool tryReap(pid_t pid, int& exitCode) {
+    int status;
+    pid_t result;
+    do {
+        result = waitpid(pid, &status, WNOHANG);
+    } while (result < 0 && errno == EINTR);
+    if (result == 0) {
+        return false;
+    }
+    exitCode = result == pid ? exitCodeOf(status) : 1;
+    return true;
+}
+
+#ifndef __linux__
+// Self-pipe used where signalfd does not exist.
+int signalPipe[2] = {-1, -1};
+
+void writeSignal(int signo) {
+    int savedErrno = errno;
+    char byte = static_cast<char>(signo);
+    ssize_t ignored = write(signalPipe[1], &byte, 1);
+    (void)ignored;
+    errno = savedErrno;
+}
+#endif
+
+#ifdef __linux__
+uint32_t toEpoll(uint32_t events) {
+    const auto in = static_cast<uint32_t>(EPOLLIN);
+    const auto out = static_cast<uint32_t>(EPOLLOUT);
+    return ((events & EventLoop::kReadable) ? in : 0) |
+           ((events & EventLoop::kWritable) ? out : 0);
+}
+
+uint32_t fromEpoll(uint32_t events) {
+    const auto in = static_cast<uint32_t>(EPOLLIN);
+    const auto out = static_cast<uint32_t>(EPOLLOUT);
+    const auto closed = static_cast<uint32_t>(EPOLLHUP | EPOLLERR);
+    return ((events & in) ? EventLoop::kReadable : 0) |
+           ((events & out) ? EventLoop::kWritable : 0) |
+           ((events & closed) ? EventLoop::kClosed : 0);
+}
+#endif
+
+short toPoll(uint32_t events) {
+    return static_cast<short>(((events & EventLoop::kReadable) ? POLLIN : 0) |
+                              ((events & EventLoop::kWritable) ? POLLOUT : 0));
+}
+
+uint32_t fromPoll(short events) {
+    return ((events & POLLIN) ? EventLoop::kReadable : 0) |
+           ((events & POLLOUT) ? EventLoop::kWritable : 0) |
+           ((events & (POLLHUP | POLLERR | POLLNVAL)) ? EventLoop::kClosed
+                                                      : 0);
+}
+
+}  // namespace
+
+EventLoop::EventLoop() : EventLoop(Backend::Epoll) {}
+
+EventLoop::EventLoop(Backend backend) : backend_(Backend::Poll) {
+#ifdef __linux__
+    if (backend == Backend::Epoll) {
+        epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd_ >= 0) {
+            backend_ = Backend::Epoll;
+        }
+    }
+#else
+    (void)backend;
+#endif
+}
+
+EventLoop::~EventLoop() {
+    for (int fd : ownedFds_) {
+        close(fd);
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+}
+
+EventLoop& EventLoop::shared() {
+    static EventLoop loop;
+    return loop;
+}
+
+bool EventLoop::watch(int fd, uint32_t events, IoHandler handler) {
+#ifdef __linux__
+    if (backend_ == Backend::Epoll) {
+        epoll_event event{};
+        event.events = toEpoll(events);
+        event.data.fd = fd;
+        int op = watches_.count(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        if (epoll_ctl(epollFd_, op, fd, &event) < 0) {
+            return false;
+        }
+    }
+#endif
+    watches_[fd] =
+        Watch{events, std::make_shared<IoHandler>(std::move(handler))};
+    return true;
+}
+
+void EventLoop::unwatch(int fd) {
+    if (watches_.erase(fd) == 0) {
+        return;
+    }
+#ifdef __linux__
+    if (backend_ == Backend::Epoll) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+#endif
+}
+
+void EventLoop::watchChild(pid_t pid, ChildHandler handler) {
+    int pidfd = openPidfd(pid);
+    if (pidfd < 0) {
+        polledChildren_.push_back({pid, std::move(handler)});
+        return;
+    }
+
+    ownedFds_.push_back(pidfd);
+    watch(pidfd, kReadable,
+          [this, pid, pidfd, handler = std::move(handler)](uint32_t) {
+              int exitCode;
+              if (!tryReap(pid, exitCode)) {
+                  return;
+              }
+              unwatch(pidfd);
+              ownedFds_.erase(
+                  std::find(ownedFds_.begin(), ownedFds_.end(), pidfd));
+              close(pidfd);
+              handler(exitCode);
+          });
+}
+
+bool EventLoop::watchSignal(int signo, SignalHandler handler) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, signo);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+#ifdef __linux__
+    int fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+        return false;
+    }
+    ownedFds_.push_back(fd);
+    return watch(fd, kReadable, [fd, handler = std::move(handler)](uint32_t) {
+        signalfd_siginfo info;
+        while (read(fd, &info, sizeof(info)) == sizeof(info)) {
+            handler(static_cast<int>(info.ssi_signo));
+        }
+    });
+#else
+    if (signalPipe[0] < 0) {
+        if (pipe(signalPipe) < 0) {
+            return false;
+        }
+        for (int fd : signalPipe) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+    struct sigaction action {};
+    action.sa_handler = writeSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(signo, &action, nullptr);
+    pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+
+    int fd = signalPipe[0];
+    return watch(fd, kReadable,
+                 [fd, signo, handler = std::move(handler)](uint32_t) {
+                     char byte;
+                     while (read(fd, &byte, 1) == 1) {
+                         if (byte == signo) {
+                             handler(signo);
+                         }
+                     }
+                 });
+#endif
+}
+
+bool EventLoop::runOnce(int timeoutMs) {
+    if (empty()) {
+        return false;
+    }
+
+    if (!polledChildren_.empty()) {
+        if (reapPolledChildren()) {
+            pollDelayMs_ = 1;
+            return true;
+        }
+        if (timeoutMs < 0 || timeoutMs > pollDelayMs_) {
+            timeoutMs = pollDelayMs_;
+        }
+    }
+
+#ifdef __linux__
+    if (backend_ == Backend::Epoll) {
+        epoll_event events[64];
+        int n = epoll_wait(epollFd_, events, 64, timeoutMs);
+        for (int k = 0; k < n; k++) {
+            dispatch(events[k].data.fd, fromEpoll(events[k].events));
+        }
+    } else
+#endif
+    {
+        std::vector<pollfd> fds;
+        fds.reserve(watches_.size());
+        for (const auto& [fd, watch] : watches_) {
+            fds.push_back({fd, toPoll(watch.events), 0});
+        }
+        int n = poll(fds.data(), fds.size(), timeoutMs);
+        for (size_t k = 0; n > 0 && k < fds.size(); k++) {
+            if (fds[k].revents != 0) {
+                dispatch(fds[k].fd, fromPoll(fds[k].revents));
+            }
+        }
+    }
+
+    if (!polledChildren_.empty()) {
+        pollDelayMs_ = reapPolledChildren()
+                           ? 1
+                           : std::min(pollDelayMs_ * 2, kMaxPollDelayMs);
+    }
+    return true;
+}
+
+void EventLoop::run() {
+    stopped_ = false;
+    while (!stopped_ && runOnce(-1)) {
+    }
+}
+
+void EventLoop::dispatch(int fd, uint32_t events) {
+    auto it = watches_.find(fd);
+    if (it == watches_.end()) {
+        return;
+    }
+    // The handler may remove its own watch; keep it alive meanwhile.
+    std::shared_ptr<IoHandler> handler = it->second.handler;
+    (*handler)(events);
+}
+
+bool EventLoop::reapPolledChildren() {
+    std::vector<std::pair<ChildHandler, int>> exited;
+    for (auto it = polledChildren_.begin(); it != polledChildren_.end();) {
+        int exitCode;
+        if (!tryReap(it->pid, exitCode)) {
+            ++it;
+            continue;
+        }
+        exited.emplace_back(std::move(it->handler), exitCode);
+        it = polledChildren_.erase(it);
+    }
+
+    // Handlers run last: they may watch more children.
+    for (auto& [handler, exitCode] : exited) {
+        handler(exitCode);
+    }
+    return !exited.empty();
+}
+#endif
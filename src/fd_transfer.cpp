@@ -0,0 +1,231 @@
+#include "fd_transfer.h"
+
+#include <cerrno>
+#include <vector>
+
+#include "source_sink.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#endif
+
+namespace {
+
+// Captured during static initialization, before anyone can swap the
+// rdbuf of std::cin/std::cout/std::cerr (tests do that to capture output).
+const std::streambuf* const kStdinBuf = std::cin.rdbuf();
+const std::streambuf* const kStdoutBuf = std::cout.rdbuf();
+const std::streambuf* const kStderrBuf = std::cerr.rdbuf();
+const std::streambuf* const kClogBuf = std::clog.rdbuf();
+
+#ifdef _WIN32
+long readSome(int fd, char* buffer, size_t size) {
+    return _read(fd, buffer, static_cast<unsigned int>(size));
+}
+
+long writeSome(int fd, const char* buffer, size_t size) {
+    return _write(fd, buffer, static_cast<unsigned int>(size));
+}
+#else
+ssize_t readSome(int fd, char* buffer, size_t size) {
+    ssize_t n;
+    do {
+        n = read(fd, buffer, size);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+ssize_t writeSome(int fd, const char* buffer, size_t size) {
+    ssize_t n;
+    do {
+        n = write(fd, buffer, size);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+#endif
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        auto n = writeSome(fd, data, size);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readWriteCopy(int inFd, int outFd) {
+    std::vector<char> buffer(FdTransfer::kBlockSize);
+    while (true) {
+        auto n = readSome(inFd, buffer.data(), buffer.size());
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        if (!writeAll(outFd, buffer.data(), static_cast<size_t>(n))) {
+            return false;
+        }
+    }
+}
+
+#ifdef __linux__
+enum class KernelCopy { Done, Failed, Unsupported };
+
+// Errors meaning "this syscall cannot handle this pair of descriptors";
+// the caller moves on to the next strategy from the current offset.
+bool isUnsupported(int err) {
+    return err == EINVAL || err == ENOSYS || err == EXDEV || err == EBADF ||
+           err == EOPNOTSUPP || err == ENOTSUP || err == EPERM;
+}
+
+constexpr size_t kKernelChunk = 1u << 30;
+
+// Offsets are implicit, so whichever strategy runs next continues from
+// where a failed one stopped.
+template <typename Step>
+KernelCopy kernelLoop(Step step) {
+    while (true) {
+        ssize_t n = step();
+        if (n > 0) {
+            continue;
+        }
+        if (n == 0) {
+            return KernelCopy::Done;
+        }
+        if (errno == EINTR || errno == EAGAIN) {
+            continue;
+        }
+        if (isUnsupported(errno)) {
+            return KernelCopy::Unsupported;
+        }
+        return KernelCopy::Failed;
+    }
+}
+
+KernelCopy copyFileRange(int inFd, int outFd) {
+    return kernelLoop([&] {
+        return copy_file_range(inFd, nullptr, outFd, nullptr, kKernelChunk,
+                               0);
+    });
+}
+
+KernelCopy sendFile(int inFd, int outFd) {
+    return kernelLoop(
+        [&] { return sendfile(outFd, inFd, nullptr, kKernelChunk); });
+}
+
+KernelCopy spliceToPipe(int inFd, int outFd) {
+    return kernelLoop([&] {
+        return splice(inFd, nullptr, outFd, nullptr, kKernelChunk,
+                      SPLICE_F_MOVE | SPLICE_F_MORE);
+    });
+}
+
+KernelCopy tryKernelCopy(int inFd, int outFd) {
+    struct stat inStat;
+    struct stat outStat;
+    if (fstat(inFd, &inStat) != 0 || fstat(outFd, &outStat) != 0 ||
+        !S_ISREG(inStat.st_mode)) {
+        return KernelCopy::Unsupported;
+    }
+
+    if (S_ISFIFO(outStat.st_mode)) {
+        return spliceToPipe(inFd, outFd);
+    }
+
+    if (S_ISREG(outStat.st_mode)) {
+        auto result = copyFileRange(inFd, outFd);
+        if (result != KernelCopy::Unsupported) {
+            return result;
+        }
+    }
+
+    return sendFile(inFd, outFd);
+}
+#endif
+
+}  // namespace
+
+bool FdTransfer::copy(int inFd, int outFd) {
+#ifdef __linux__
+    switch (tryKernelCopy(inFd, outFd)) {
+        case KernelCopy::Done:
+            return true;
+        case KernelCopy::Failed:
+            return false;
+        case KernelCopy::Unsupported:
+            break;
+    }
+#endif
+    return readWriteCopy(inFd, outFd);
+}
+
+bool FdTransfer::copy(Source& input, Sink& output) {
+    int inFd = input.fd();
+    int outFd = output.fd();
+    if (inFd >= 0 && outFd >= 0) {
+        return output.flush() && copy(inFd, outFd);
+    }
+
+    const char* data;
+    size_t size;
+    while (input.next(data, size)) {
+        if (!output.write(data, size)) {
+            return false;
+        }
+    }
+    return !input.failed();
+}
+
+int FdTransfer::streamDescriptor(const std::ostream& stream) {
+#ifdef _WIN32
+    (void)stream;
+    return -1;
+#else
+    const std::streambuf* buf = stream.rdbuf();
+    if (buf == nullptr) {
+        return -1;
+    }
+    if (buf == kStdoutBuf) {
+        return STDOUT_FILENO;
+    }
+    if (buf == kStderrBuf || buf == kClogBuf) {
+        return STDERR_FILENO;
+    }
+    if (auto sinkBuf = dynamic_cast<const SinkStreambuf*>(buf)) {
+        return sinkBuf->sink().fd();
+    }
+    return -1;
+#endif
+}
+
+int FdTransfer::streamDescriptor(const std::istream& stream) {
+#ifdef _WIN32
+    (void)stream;
+    return -1;
+#else
+    const std::streambuf* buf = stream.rdbuf();
+    if (buf == nullptr) {
+        return -1;
+    }
+    if (buf == kStdinBuf) {
+        return STDIN_FILENO;
+    }
+    if (auto sourceBuf = dynamic_cast<const SourceStreambuf*>(buf)) {
+        return sourceBuf->source().fd();
+    }
+    return -1;
+#endif
+}
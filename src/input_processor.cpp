@@ -1,7 +1,69 @@
 #include "input_processor.h"
 
-InputProcessor::InputProcessor(std::istream& input) : input_(input) {}
+#ifndef _WIN32
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "event_loop.h"
+#endif
+
+InputProcessor::InputProcessor(std::istream& input) : input_(&input) {}
+
+#ifndef _WIN32
+InputProcessor::InputProcessor(int fd, EventLoop& loop,
+                               std::function<void()> onWait)
+    : fd_(fd), loop_(&loop), onWait_(std::move(onWait)) {}
+#endif
 
 bool InputProcessor::readLine(std::string& line) {
-    return static_cast<bool>(std::getline(input_, line));
+#ifndef _WIN32
+    if (loop_) {
+        return readFromDescriptor(line);
+    }
+#endif
+    return static_cast<bool>(std::getline(*input_, line));
+}
+
+#ifndef _WIN32
+bool InputProcessor::readFromDescriptor(std::string& line) {
+    while (true) {
+        size_t newline = buffer_.find('\n');
+        if (newline != std::string::npos) {
+            line.assign(buffer_, 0, newline);
+            buffer_.erase(0, newline + 1);
+            return true;
+        }
+        if (eof_) {
+            if (buffer_.empty()) {
+                return false;
+            }
+            line = std::move(buffer_);
+            buffer_.clear();
+            return true;
+        }
+
+        bool ready = false;
+        if (!loop_->watch(fd_, EventLoop::kReadable,
+                          [&ready](uint32_t) { ready = true; })) {
+            // Not pollable (e.g. a regular file): just read it.
+            ready = true;
+        }
+        while (!ready) {
+            loop_->runOnce(-1);
+            if (onWait_) {
+                onWait_();
+            }
+        }
+        loop_->unwatch(fd_);
+
+        char chunk[4096];
+        ssize_t n = read(fd_, chunk, sizeof(chunk));
+        if (n > 0) {
+            buffer_.append(chunk, static_cast<size_t>(n));
+        } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+            eof_ = true;
+        }
+    }
 }
+#endif
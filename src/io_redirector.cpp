@@ -1,28 +1,48 @@
 #include "io_redirector.h"
 
+#include <cerrno>
+#include <cstring>
+
 #ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
 #include <windows.h>
 #else
+#include <fcntl.h>
 #include <unistd.h>
+#endif
 
-#include <cstring>
+bool IORedirector::openPipe(int fds[2]) {
+#ifdef _WIN32
+    return false;
+#elif defined(__APPLE__)
+    if (pipe(fds) == -1) {
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#else
+    return pipe2(fds, O_CLOEXEC) == 0;
 #endif
+}
 
 bool IORedirector::createPipes(int count) {
+    return createPipes(std::vector<bool>(count > 0 ? count : 0, true));
+}
+
+bool IORedirector::createPipes(const std::vector<bool>& links) {
 #ifdef _WIN32
     return false;
 #else
-    for (int i = 0; i < count; i++) {
-        int* pipefd = new int[2];
-        if (pipe(pipefd) == -1) {
-            for (auto p : pipes_) {
-                close(p[0]);
-                close(p[1]);
-                delete[] p;
+    for (bool needed : links) {
+        std::array<int, 2> pipefd = {-1, -1};
+        if (needed) {
+            if (!openPipe(pipefd.data())) {
+                closeAllPipes();
+                return false;
             }
-            pipes_.clear();
-            delete[] pipefd;
-            return false;
         }
         pipes_.push_back(pipefd);
     }
@@ -32,25 +52,97 @@ bool IORedirector::createPipes(int count) {
 
 void IORedirector::setupChildPipes(int index, int totalCommands) {
 #ifndef _WIN32
-    if (index > 0) {
+    if (index > 0 && pipes_[index - 1][0] >= 0) {
         dup2(pipes_[index - 1][0], STDIN_FILENO);
     }
 
-    if (index < totalCommands - 1) {
+    if (index < totalCommands - 1 && pipes_[index][1] >= 0) {
         dup2(pipes_[index][1], STDOUT_FILENO);
     }
 #endif
 }
 
+int IORedirector::readEnd(int link) const { return pipes_[link][0]; }
+
+int IORedirector::writeEnd(int link) const { return pipes_[link][1]; }
+
+int IORedirector::releaseReadEnd(int link) {
+    int fd = pipes_[link][0];
+    pipes_[link][0] = -1;
+    return fd;
+}
+
+int IORedirector::releaseWriteEnd(int link) {
+    int fd = pipes_[link][1];
+    pipes_[link][1] = -1;
+    return fd;
+}
+
+int IORedirector::openFile(const Redirection& redirection) {
+    int flags = 0;
+    switch (redirection.kind) {
+        case Redirection::Kind::Input:
+            flags = O_RDONLY;
+            break;
+        case Redirection::Kind::Output:
+            flags = O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+        case Redirection::Kind::Append:
+            flags = O_WRONLY | O_CREAT | O_APPEND;
+            break;
+        case Redirection::Kind::Duplicate:
+        case Redirection::Kind::Text:
+            errno = EINVAL;
+            return -1;
+    }
+
+#ifdef _WIN32
+    int fd = _open(redirection.target.c_str(), flags | _O_BINARY | _O_NOINHERIT,
+                   _S_IREAD | _S_IWRITE);
+#else
+    int fd = open(redirection.target.c_str(), flags | O_CLOEXEC, 0666);
+#endif
+    if (fd >= 0) {
+        files_.push_back(fd);
+    }
+    return fd;
+}
+
+bool IORedirector::apply(const Redirection& redirection,
+                         std::array<int, 3>& fds, std::string& errorMessage) {
+    if (redirection.kind == Redirection::Kind::Duplicate) {
+        fds[redirection.fd] = fds[redirection.targetFd];
+        return true;
+    }
+    int fd = openFile(redirection);
+    if (fd < 0) {
+        errorMessage = redirection.target + ": " + std::strerror(errno);
+        return false;
+    }
+    fds[redirection.fd] = fd;
+    return true;
+}
+
 void IORedirector::closeAllPipes() {
-#ifndef _WIN32
-    for (auto p : pipes_) {
-        close(p[0]);
-        close(p[1]);
-        delete[] p;
+#ifdef _WIN32
+    for (int fd : files_) {
+        _close(fd);
+    }
+#else
+    for (const auto& p : pipes_) {
+        if (p[0] >= 0) {
+            close(p[0]);
+        }
+        if (p[1] >= 0) {
+            close(p[1]);
+        }
+    }
+    for (int fd : files_) {
+        close(fd);
     }
-    pipes_.clear();
 #endif
+    pipes_.clear();
+    files_.clear();
 }
 
 IORedirector::~IORedirector() { closeAllPipes(); }
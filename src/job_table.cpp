@@ -0,0 +1,123 @@
+#include "job_table.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdlib>
+
+#include "event_loop.h"
+
+JobTable& JobTable::getInstance() {
+    static JobTable instance;
+    return instance;
+}
+
+JobTable::JobTable() : owner_(getpid()) {}
+
+int JobTable::add(pid_t pid, const std::string& command) {
+    int id = jobs_.empty() ? 1 : jobs_.rbegin()->first + 1;
+    jobs_.emplace(id, Job{id, pid, command, State::Running, 0});
+
+    if (isOwner()) {
+        EventLoop::shared().watchChild(pid, [this, id](int exitCode) {
+            auto it = jobs_.find(id);
+            if (it != jobs_.end()) {
+                it->second.state = State::Done;
+                it->second.exitCode = exitCode;
+            }
+        });
+    }
+    return id;
+}
+
+void JobTable::reapFinished() {
+    if (isOwner()) {
+        EventLoop::shared().runOnce(0);
+    }
+}
+
+std::vector<JobTable::Job> JobTable::jobs() const {
+    std::vector<Job> result;
+    for (const auto& [id, job] : jobs_) {
+        result.push_back(job);
+    }
+    return result;
+}
+
+std::vector<JobTable::Job> JobTable::takeFinished() {
+    std::vector<Job> result;
+    for (auto it = jobs_.begin(); it != jobs_.end();) {
+        if (it->second.state == State::Done) {
+            result.push_back(it->second);
+            it = jobs_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return result;
+}
+
+int JobTable::wait(int id) {
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return -1;
+    }
+
+    // Other jobs finishing meanwhile are reaped too.
+    while (it->second.state == State::Running && isOwner() &&
+           EventLoop::shared().runOnce(-1)) {
+    }
+
+    int exitCode = it->second.exitCode;
+    jobs_.erase(it);
+    return exitCode;
+}
+
+int JobTable::resolve(const std::string& spec) const {
+    if (spec == "%%" || spec == "%+") {
+        return current();
+    }
+
+    bool isJobNumber = !spec.empty() && spec[0] == '%';
+    std::string digits = isJobNumber ? spec.substr(1) : spec;
+    if (digits.empty()) {
+        return 0;
+    }
+    for (char ch : digits) {
+        if (!std::isdigit(static_cast<unsigned char>(ch))) {
+            return 0;
+        }
+    }
+
+    long number = std::strtol(digits.c_str(), nullptr, 10);
+    for (const auto& [id, job] : jobs_) {
+        if (isJobNumber ? id == number : job.pid == number) {
+            return id;
+        }
+    }
+    return 0;
+}
+
+int JobTable::current() const {
+    return jobs_.empty() ? 0 : jobs_.rbegin()->first;
+}
+
+std::string JobTable::describe(const Job& job) {
+    std::string state;
+    if (job.state == State::Running) {
+        state = "Running";
+    } else if (job.exitCode == 0) {
+        state = "Done";
+    } else {
+        state = "Exit " + std::to_string(job.exitCode);
+    }
+    return "[" + std::to_string(job.id) + "]  " + state + "\t" + job.command;
+}
+
+bool JobTable::isOwner() const {
+    // A forked child shares the loop's epoll set with the interpreter and
+    // must leave it alone.
+    return getpid() == owner_;
+}
+#endif
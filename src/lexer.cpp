@@ -1,9 +1,45 @@
 #include "lexer.h"
 
+#include <cctype>
+
+namespace {
+
+bool isSpace(char ch) { return std::isspace(static_cast<unsigned char>(ch)); }
+
+bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+
+bool isRedirectChar(char ch) { return ch == '<' || ch == '>'; }
+
+bool isWordChar(char ch) {
+    return !isSpace(ch) && ch != '\'' && ch != '"' && ch != '|' &&
+           ch != '&' && !isRedirectChar(ch);
+}
+
+}  // namespace
+
 std::vector<Token> Lexer::tokenize(const std::string& input) {
+    std::vector<TokenView> views;
+    tokenizeView(input, views);
+
+    std::vector<Token> tokens;
+    tokens.reserve(views.size());
+    for (const auto& view : views) {
+        tokens.emplace_back(view);
+    }
+    return tokens;
+}
+
+std::vector<TokenView> Lexer::tokenizeView(std::string_view input) {
+    std::vector<TokenView> tokens;
+    tokenizeView(input, tokens);
+    return tokens;
+}
+
+void Lexer::tokenizeView(std::string_view input,
+                         std::vector<TokenView>& tokens) {
     input_ = input;
     pos_ = 0;
-    std::vector<Token> tokens;
+    tokens.clear();
 
     while (pos_ < input_.length()) {
         skipWhitespace();
@@ -14,54 +50,81 @@ std::vector<Token> Lexer::tokenize(const std::string& input) {
         if (ch == '\'' || ch == '"') {
             tokens.push_back(readQuotedToken(ch));
         } else if (ch == '|') {
-            tokens.push_back(readPipeToken());
+            tokens.push_back(readOperatorToken(TokenType::PIPE));
+        } else if (ch == '&') {
+            tokens.push_back(readOperatorToken(TokenType::BACKGROUND));
+        } else if (atRedirect()) {
+            tokens.push_back(readRedirectToken());
         } else {
             tokens.push_back(readWordToken());
         }
     }
-
-    return tokens;
 }
 
 void Lexer::skipWhitespace() {
-    while (pos_ < input_.length() && std::isspace(input_[pos_])) {
+    while (pos_ < input_.length() && isSpace(input_[pos_])) {
         pos_++;
     }
 }
 
-Token Lexer::readQuotedToken(char quote) {
+TokenView Lexer::readQuotedToken(char quote) {
     pos_++;
-    std::string value;
+    size_t start = pos_;
 
-    while (pos_ < input_.length() && input_[pos_] != quote) {
-        value += input_[pos_++];
-    }
-
-    if (pos_ < input_.length()) {
-        pos_++;
+    size_t end = input_.find(quote, pos_);
+    if (end == std::string_view::npos) {
+        end = input_.length();
     }
+    pos_ = end < input_.length() ? end + 1 : end;
 
     TokenType type =
         (quote == '\'') ? TokenType::QUOTED_SINGLE : TokenType::QUOTED_DOUBLE;
-    return Token(type, value);
+    return TokenView{type, input_.substr(start, end - start)};
 }
 
-Token Lexer::readWordToken() {
-    std::string value;
+TokenView Lexer::readWordToken() {
+    size_t start = pos_;
 
-    while (pos_ < input_.length() && !std::isspace(input_[pos_]) &&
-           input_[pos_] != '\'' && input_[pos_] != '"' && input_[pos_] != '|') {
-        value += input_[pos_++];
+    while (pos_ < input_.length() && isWordChar(input_[pos_])) {
+        pos_++;
     }
 
-    if (value.find('=') != std::string::npos) {
-        return Token(TokenType::ASSIGNMENT, value);
+    std::string_view value = input_.substr(start, pos_ - start);
+
+    if (value.find('=') != std::string_view::npos) {
+        return TokenView{TokenType::ASSIGNMENT, value};
     }
 
-    return Token(TokenType::WORD, value);
+    return TokenView{TokenType::WORD, value};
 }
 
-Token Lexer::readPipeToken() {
+TokenView Lexer::readOperatorToken(TokenType type) {
+    TokenView token{type, input_.substr(pos_, 1)};
     pos_++;
-    return Token(TokenType::PIPE, "|");
+    return token;
+}
+
+bool Lexer::atRedirect() const {
+    // A digit only names a descriptor when it directly precedes the
+    // operator at the start of a token, as in `2>`.
+    char ch = input_[pos_];
+    return isRedirectChar(ch) ||
+           (isDigit(ch) && pos_ + 1 < input_.length() &&
+            isRedirectChar(input_[pos_ + 1]));
+}
+
+TokenView Lexer::readRedirectToken() {
+    size_t start = pos_;
+    if (isDigit(input_[pos_])) {
+        pos_++;
+    }
+    char op = input_[pos_++];
+
+    if (op == '>' && pos_ < input_.length() && input_[pos_] == '>') {
+        pos_++;
+    } else if (pos_ + 1 < input_.length() && input_[pos_] == '&' &&
+               isDigit(input_[pos_ + 1])) {
+        pos_ += 2;
+    }
+    return TokenView{TokenType::REDIRECT, input_.substr(start, pos_ - start)};
 }
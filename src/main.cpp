@@ -1,27 +1,97 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 #include "command_executor.h"
 #include "commands/exit_command.h"
 #include "environment_manager.h"
+#include "event_loop.h"
 #include "input_processor.h"
-#include "lexer.h"
+#include "job_table.h"
 #include "parser.h"
 
-int main() {
+namespace {
+
+#ifndef _WIN32
+bool interrupted = false;
+
+// Runs while the prompt waits for input: reports jobs finishing and
+// Ctrl-C right away and shows the prompt again.
+void reportAtPrompt() {
+    bool printed = false;
+    for (const auto& job : JobTable::getInstance().takeFinished()) {
+        std::cout << (printed ? "" : "\n") << JobTable::describe(job)
+                  << "\n";
+        printed = true;
+    }
+    if (interrupted) {
+        interrupted = false;
+        std::cout << "\n";
+        printed = true;
+    }
+    if (printed) {
+        std::cout << "> ";
+        std::cout.flush();
+    }
+}
+#endif
+
+bool stdinIsTerminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdin)) != 0;
+#else
+    return isatty(STDIN_FILENO) != 0;
+#endif
+}
+
+/**
+ * @brief Reads and executes lines until end of input or exit
+ * @param inputProcessor Source of command lines
+ * @param interactive Print a prompt before each line
+ * @return Exit code of the last executed command
+ */
+int runCommands(InputProcessor& inputProcessor, bool interactive) {
     EnvironmentManager& envManager = EnvironmentManager::getInstance();
-    InputProcessor inputProcessor(std::cin);
-    Lexer lexer;
     Parser parser(envManager);
     CommandExecutor executor;
 
     std::string line;
     int lastExitCode = 0;
 
-    envManager.setVariable("?", "0");
+    envManager.setExitCode(0);
+
+#ifndef _WIN32
+    JobTable& jobs = JobTable::getInstance();
+    jobs.setNotify(interactive);
+#endif
 
     while (true) {
-        std::cout << "> ";
-        std::cout.flush();
+#ifndef _WIN32
+        // Finished background jobs are reaped between commands; a prompt
+        // is preceded by their status.
+        jobs.reapFinished();
+        if (interactive) {
+            for (const auto& job : jobs.takeFinished()) {
+                std::cout << JobTable::describe(job) << std::endl;
+            }
+        }
+#endif
+
+        if (interactive) {
+            std::cout << "> ";
+            std::cout.flush();
+        }
 
         if (!inputProcessor.readLine(line)) {
             break;
@@ -31,14 +101,13 @@ int main() {
             continue;
         }
 
-        auto tokens = lexer.tokenize(line);
-        auto command = parser.parse(tokens);
+        auto command = parser.parseLine(line);
 
         if (command) {
             lastExitCode =
                 executor.execute(command.get(), std::cin, std::cout, std::cerr);
 
-            envManager.setVariable("?", std::to_string(lastExitCode));
+            envManager.setExitCode(lastExitCode);
 
             if (ExitCommand::shouldExit()) {
                 break;
@@ -46,5 +115,57 @@ int main() {
         }
     }
 
-    return 0;
+    return lastExitCode;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::unique_ptr<std::istream> script;
+
+    if (argc > 1 && std::strcmp(argv[1], "-c") == 0) {
+        if (argc < 3) {
+            std::cerr << "cli_app: -c: option requires an argument"
+                      << std::endl;
+            return 2;
+        }
+        script = std::make_unique<std::istringstream>(argv[2]);
+    } else if (argc > 1) {
+        auto file = std::make_unique<std::ifstream>(argv[1]);
+        if (!*file) {
+            std::cerr << "cli_app: " << argv[1] << ": " << std::strerror(errno)
+                      << std::endl;
+            return 127;
+        }
+        script = std::move(file);
+    }
+
+    bool interactive = !script && stdinIsTerminal();
+
+    if (!interactive) {
+        // Nobody is waiting for a prompt: let stdout fill whole blocks.
+        // Commands flush it before starting other processes and std::cerr
+        // is tied to std::cout, so output keeps its order.
+        std::setvbuf(stdout, nullptr, _IOFBF, 64 * 1024);
+    }
+
+#ifndef _WIN32
+    if (interactive) {
+        // The terminal is read through the interpreter's loop, which also
+        // reaps background jobs and takes SIGINT so that Ctrl-C stops the
+        // foreground programs instead of the interpreter.
+        EventLoop& loop = EventLoop::shared();
+        loop.watchSignal(SIGINT, [](int) { interrupted = true; });
+        InputProcessor inputProcessor(STDIN_FILENO, loop, reportAtPrompt);
+        runCommands(inputProcessor, true);
+        std::cout.flush();
+        return 0;
+    }
+#endif
+
+    InputProcessor inputProcessor(script ? *script : std::cin);
+    int exitCode = runCommands(inputProcessor, interactive);
+
+    std::cout.flush();
+    return interactive ? 0 : exitCode;
 }
@@ -0,0 +1,252 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#endif
+
+namespace {
+
+// Pipes and special files rarely deliver more than this per read().
+constexpr size_t kReadSize = 128 * 1024;
+
+const char* const kTruncated = "file truncated while reading";
+
+#ifndef _WIN32
+// Mappings the SIGBUS handler may repair. Only atomics are touched from
+// the handler; a file that finds no free slot is read with read().
+struct GuardedRange {
+    std::atomic<bool> used{false};
+    std::atomic<uintptr_t> begin{0};
+    std::atomic<uintptr_t> end{0};
+    std::atomic<bool> truncated{false};
+};
+
+constexpr size_t kMaxGuarded = 64;
+GuardedRange guarded[kMaxGuarded];
+struct sigaction previousSigbus;
+uintptr_t pageSize = 4096;
+
+void onSigbus(int signo, siginfo_t* info, void*) {
+    auto address = reinterpret_cast<uintptr_t>(info->si_addr);
+    for (auto& range : guarded) {
+        if (address < range.begin.load() || address >= range.end.load()) {
+            continue;
+        }
+        // The access is retried on return and now reads zeros.
+        void* page = reinterpret_cast<void*>(address & ~(pageSize - 1));
+        if (mmap(page, pageSize, PROT_READ,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1,
+                 0) != MAP_FAILED) {
+            range.truncated.store(true);
+            return;
+        }
+        break;
+    }
+
+    // Not a mapped file: the previous disposition takes the fault when
+    // the access is retried, or the signal when it was sent.
+    sigaction(SIGBUS, &previousSigbus, nullptr);
+    if (info->si_code <= 0) {
+        raise(signo);
+    }
+}
+
+int guardMapping(const char* data, size_t size) {
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        long page = sysconf(_SC_PAGESIZE);
+        if (page > 0) {
+            pageSize = static_cast<uintptr_t>(page);
+        }
+        struct sigaction action {};
+        action.sa_sigaction = onSigbus;
+        action.sa_flags = SA_SIGINFO | SA_NODEFER;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGBUS, &action, &previousSigbus);
+    });
+
+    for (size_t i = 0; i < kMaxGuarded; i++) {
+        bool expected = false;
+        if (guarded[i].used.compare_exchange_strong(expected, true)) {
+            guarded[i].truncated.store(false);
+            guarded[i].begin.store(reinterpret_cast<uintptr_t>(data));
+            guarded[i].end.store(reinterpret_cast<uintptr_t>(data) + size);
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void unguardMapping(int slot) {
+    guarded[slot].end.store(0);
+    guarded[slot].begin.store(0);
+    guarded[slot].used.store(false);
+}
+#endif
+
+}  // namespace
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& path, std::string& errorMessage) {
+    close();
+
+#ifdef _WIN32
+    fd_ = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    if (fd_ < 0) {
+        errorMessage = strerror(errno);
+        return false;
+    }
+
+#ifndef _WIN32
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        errorMessage = strerror(errno);
+        close();
+        return false;
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+        errorMessage = strerror(EISDIR);
+        close();
+        return false;
+    }
+
+    // Files reporting size 0 (empty files, /proc and sysfs entries) and
+    // anything that cannot be mapped are read with read() below.
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        auto size = static_cast<size_t>(st.st_size);
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (mapping != MAP_FAILED) {
+            guard_ = guardMapping(static_cast<char*>(mapping), size);
+            if (guard_ < 0) {
+                munmap(mapping, size);
+                return true;
+            }
+            mapping_ = static_cast<char*>(mapping);
+            size_ = size;
+            madvise(mapping_, size_, MADV_SEQUENTIAL);
+            madvise(mapping_, size_ < kBlockSize ? size_ : kBlockSize,
+                    MADV_WILLNEED);
+        }
+    }
+#endif
+    return true;
+}
+
+bool MappedFile::next(const char*& data, size_t& size) {
+    if (fd_ < 0 || failed_) {
+        return false;
+    }
+
+    if (mapping_) {
+        if (offset_ >= size_ || truncated()) {
+            return false;
+        }
+        data = mapping_ + offset_;
+        size = size_ - offset_ < kBlockSize ? size_ - offset_ : kBlockSize;
+
+#ifndef _WIN32
+        // Never hand out pages past the end of a file that shrank.
+        struct stat st;
+        if (fstat(fd_, &st) == 0 &&
+            static_cast<size_t>(st.st_size) < offset_ + size) {
+            failed_ = true;
+            errorMessage_ = kTruncated;
+            return false;
+        }
+#endif
+        offset_ += size;
+
+#ifndef _WIN32
+        // Ask for the window after this one while the caller works.
+        if (offset_ < size_) {
+            size_t ahead = size_ - offset_ < kBlockSize ? size_ - offset_
+                                                        : kBlockSize;
+            madvise(mapping_ + offset_, ahead, MADV_WILLNEED);
+        }
+#endif
+        return true;
+    }
+
+    if (buffer_.empty()) {
+        buffer_.resize(kReadSize);
+    }
+
+    while (true) {
+#ifdef _WIN32
+        int n = _read(fd_, buffer_.data(),
+                      static_cast<unsigned int>(buffer_.size()));
+#else
+        ssize_t n = read(fd_, buffer_.data(), buffer_.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (n < 0) {
+            failed_ = true;
+            errorMessage_ = strerror(errno);
+            return false;
+        }
+        if (n == 0) {
+            return false;
+        }
+        data = buffer_.data();
+        size = static_cast<size_t>(n);
+        return true;
+    }
+}
+
+const std::string& MappedFile::errorMessage() const {
+    static const std::string truncatedMessage = kTruncated;
+    return errorMessage_.empty() && truncated() ? truncatedMessage
+                                                : errorMessage_;
+}
+
+bool MappedFile::truncated() const {
+#ifndef _WIN32
+    return guard_ >= 0 && guarded[guard_].truncated.load();
+#else
+    return false;
+#endif
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapping_) {
+        unguardMapping(guard_);
+        munmap(mapping_, size_);
+    }
+#endif
+    guard_ = -1;
+    if (fd_ >= 0) {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        ::close(fd_);
+#endif
+    }
+    fd_ = -1;
+    mapping_ = nullptr;
+    size_ = 0;
+    offset_ = 0;
+    failed_ = false;
+    errorMessage_.clear();
+}
@@ -0,0 +1,42 @@
+#include "parse_cache.h"
+
+ParseCache::ParseCache(size_t capacity) : capacity_(capacity) {}
+
+std::shared_ptr<const CommandPlan> ParseCache::find(std::string_view line) {
+    auto it = index_.find(line);
+    if (it == index_.end()) {
+        misses_++;
+        return nullptr;
+    }
+
+    hits_++;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+}
+
+void ParseCache::insert(std::string line,
+                        std::shared_ptr<const CommandPlan> plan) {
+    if (capacity_ == 0) {
+        return;
+    }
+
+    auto it = index_.find(line);
+    if (it != index_.end()) {
+        it->second->second = std::move(plan);
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+
+    if (entries_.size() >= capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+
+    entries_.emplace_front(std::move(line), std::move(plan));
+    index_.emplace(entries_.front().first, entries_.begin());
+}
+
+void ParseCache::clear() {
+    index_.clear();
+    entries_.clear();
+}
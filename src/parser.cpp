@@ -1,23 +1,118 @@
 #include "parser.h"
 
+#include <cctype>
 #include <iostream>
 
 #include "command_factory.h"
 #include "commands/abstract_command.h"
-#include "commands/pipeline_command.h"
 #include "environment_manager.h"
+#include "pipeline_optimizer.h"
+#include "variable_expander.h"
+
+namespace {
+
+// Kind and descriptors of a REDIRECT token's operator ("2>", ">>", "2>&1").
+RedirectPlan redirectOperator(std::string_view op) {
+    RedirectPlan redirect;
+    size_t pos = 0;
+    bool explicitFd = std::isdigit(static_cast<unsigned char>(op[0])) != 0;
+    if (explicitFd) {
+        pos++;
+    }
+    bool input = op[pos] == '<';
+    redirect.fd = explicitFd ? op[0] - '0' : (input ? 0 : 1);
+
+    std::string_view rest = op.substr(pos + 1);
+    if (rest.size() == 2 && rest[0] == '&') {
+        redirect.kind = Redirection::Kind::Duplicate;
+        redirect.targetFd = rest[1] - '0';
+    } else if (rest == ">") {
+        redirect.kind = Redirection::Kind::Append;
+    } else {
+        redirect.kind =
+            input ? Redirection::Kind::Input : Redirection::Kind::Output;
+    }
+    return redirect;
+}
+
+bool isSupported(const RedirectPlan& redirect) {
+    auto isOutput = [](int fd) { return fd == 1 || fd == 2; };
+    switch (redirect.kind) {
+        case Redirection::Kind::Input:
+            return redirect.fd == 0;
+        case Redirection::Kind::Duplicate:
+            return isOutput(redirect.fd) && isOutput(redirect.targetFd);
+        default:
+            return isOutput(redirect.fd);
+    }
+}
+
+}  // namespace
 
 Parser::Parser(EnvironmentManager& envManager) : envManager_(envManager) {}
 
 std::unique_ptr<AbstractCommand> Parser::parse(
     const std::vector<Token>& tokens) {
+    std::vector<TokenView> views;
+    views.reserve(tokens.size());
+    for (const auto& token : tokens) {
+        views.push_back({token.type, token.value});
+    }
+    auto plan = compile(views);
+    if (!plan) {
+        return nullptr;
+    }
+    return bind(*plan);
+}
+
+std::unique_ptr<AbstractCommand> Parser::parseLine(const std::string& line) {
+    auto plan = cache_.find(line);
+    if (!plan) {
+        lexer_.tokenizeView(line, views_);
+        plan = compile(views_);
+        if (!plan) {
+            return nullptr;
+        }
+        cache_.insert(line, plan);
+    }
+    return bind(*plan);
+}
+
+BuiltinId Parser::registerBuiltin(const std::string& name,
+                                  BuiltinCreator create) {
+    // Cached plans may have resolved name to another command.
+    cache_.clear();
+    return factory_.registerBuiltin(name, create);
+}
+
+std::shared_ptr<const CommandPlan> Parser::compile(
+    const std::vector<TokenView>& tokens) {
     if (tokens.empty()) {
         return nullptr;
     }
 
+    // A trailing '&' runs the whole line as a background job.
+    if (tokens.back().type == TokenType::BACKGROUND) {
+        std::vector<TokenView> jobTokens(tokens.begin(), tokens.end() - 1);
+        auto plan = compile(jobTokens);
+        if (!plan || plan->isAssignment()) {
+            return plan;
+        }
+        return CommandPlan::background(plan->stages(), jobText(tokens));
+    }
+    for (const auto& token : tokens) {
+        if (token.type == TokenType::BACKGROUND) {
+            std::cerr << "Syntax error: '&' must end the command" << std::endl;
+            return nullptr;
+        }
+    }
+
     if (isAssignment(tokens)) {
-        handleAssignment(tokens);
-        return nullptr;
+        std::string_view assignment = tokens[0].value;
+        size_t eqPos = assignment.find('=');
+        return CommandPlan::assignment(
+            std::string(assignment.substr(0, eqPos)),
+            std::string(assignment.substr(eqPos + 1)));
     }
 
     auto commandTokens = splitByPipe(tokens);
@@ -27,50 +122,72 @@ std::unique_ptr<AbstractCommand> Parser::parse(
         std::cerr << "Syntax error: " << errorMessage << std::endl;
         return nullptr;
     }
-
-    if (commandTokens.size() == 1) {
-        return parseSingleCommand(commandTokens[0]);
-    }
-
-    std::vector<std::unique_ptr<AbstractCommand>> commands;
     for (const auto& cmdTokens : commandTokens) {
-        auto cmd = parseSingleCommand(cmdTokens);
-        if (!cmd) {
+        if (!validateRedirections(cmdTokens, errorMessage)) {
+            std::cerr << "Syntax error: " << errorMessage << std::endl;
             return nullptr;
         }
-        commands.push_back(std::move(cmd));
     }
 
-    return std::make_unique<PipelineCommand>(std::move(commands));
+    std::vector<StagePlan> stages;
+    stages.reserve(commandTokens.size());
+    for (const auto& cmdTokens : commandTokens) {
+        stages.push_back(compileStage(cmdTokens));
+    }
+    return CommandPlan::pipeline(std::move(stages));
 }
 
-std::unique_ptr<AbstractCommand> Parser::parseSingleCommand(
-    const std::vector<Token>& tokens) {
-    if (tokens.empty()) {
-        return nullptr;
+std::unique_ptr<AbstractCommand> Parser::bind(const CommandPlan& plan) {
+    // Rewrites depend on files and options, so they are redone on every
+    // bind instead of being cached with the plan.
+    std::shared_ptr<const CommandPlan> optimized;
+    if (optimize_ && !plan.isAssignment() && plan.stages().size() > 1 &&
+        !envManager_.pipefail()) {
+        std::vector<StagePlan> stages = plan.stages();
+        auto folded = PipelineOptimizer(factory_).optimize(
+            stages, *envManager_.snapshot(), plan.isBackground());
+        if (!folded.empty()) {
+            optimized = plan.rewritten(std::move(stages), std::move(folded));
+        }
     }
+    const CommandPlan& bound = optimized ? *optimized : plan;
 
-    std::vector<std::string> args;
-
-    for (const auto& token : tokens) {
-        args.push_back(resolveValue(token));
+    if (envManager_.showPlan()) {
+        std::cerr << "plan: " << bound.describe() << std::endl;
     }
+    return bound.bind(envManager_, factory_);
+}
 
-    if (args.empty()) {
-        return nullptr;
-    }
+StagePlan Parser::compileStage(const std::vector<TokenView>& tokens) {
+    StagePlan stage;
+    stage.words.reserve(tokens.size());
+    const std::string_view* name = nullptr;
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (tokens[i].type != TokenType::REDIRECT) {
+            if (!name) {
+                name = &tokens[i].value;
+            }
+            stage.words.push_back(compileWord(tokens[i]));
+            continue;
+        }
 
-    std::string commandName = args[0];
-    args.erase(args.begin());
+        RedirectPlan redirect = redirectOperator(tokens[i].value);
+        if (redirect.kind != Redirection::Kind::Duplicate) {
+            redirect.target = compileWord(tokens[++i]);
+        }
+        stage.redirects.push_back(std::move(redirect));
+    }
 
-    CommandFactory factory;
-    return factory.createCommand(commandName, args);
+    if (stage.words[0].isLiteral()) {
+        stage.builtin = factory_.findBuiltin(*name);
+    }
+    return stage;
 }
 
-std::vector<std::vector<Token>> Parser::splitByPipe(
-    const std::vector<Token>& tokens) {
-    std::vector<std::vector<Token>> result;
-    std::vector<Token> currentCommand;
+std::vector<std::vector<TokenView>> Parser::splitByPipe(
+    const std::vector<TokenView>& tokens) {
+    std::vector<std::vector<TokenView>> result;
+    std::vector<TokenView> currentCommand;
 
     for (const auto& token : tokens) {
         if (token.type == TokenType::PIPE) {
@@ -87,7 +204,7 @@ std::vector<std::vector<Token>> Parser::splitByPipe(
 }
 
 bool Parser::validatePipeline(
-    const std::vector<std::vector<Token>>& commandTokens,
+    const std::vector<std::vector<TokenView>>& commandTokens,
     std::string& errorMessage) {
     if (commandTokens.empty()) {
         errorMessage = "empty pipeline";
@@ -110,65 +227,69 @@ bool Parser::validatePipeline(
     return true;
 }
 
-bool Parser::isAssignment(const std::vector<Token>& tokens) {
-    return tokens.size() == 1 && tokens[0].type == TokenType::ASSIGNMENT;
-}
+bool Parser::validateRedirections(const std::vector<TokenView>& tokens,
+                                  std::string& errorMessage) {
+    bool hasWord = false;
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (tokens[i].type != TokenType::REDIRECT) {
+            hasWord = true;
+            continue;
+        }
 
-void Parser::handleAssignment(const std::vector<Token>& tokens) {
-    std::string assignment = tokens[0].value;
-    size_t eqPos = assignment.find('=');
+        RedirectPlan redirect = redirectOperator(tokens[i].value);
+        if (!isSupported(redirect)) {
+            errorMessage =
+                "unsupported redirection '" + tokens[i].str() + "'";
+            return false;
+        }
+        if (redirect.kind == Redirection::Kind::Duplicate) {
+            continue;
+        }
+        if (i + 1 == tokens.size() ||
+            tokens[i + 1].type == TokenType::REDIRECT) {
+            errorMessage =
+                "missing file name after '" + tokens[i].str() + "'";
+            return false;
+        }
+        i++;
+    }
 
-    if (eqPos != std::string::npos) {
-        std::string name = assignment.substr(0, eqPos);
-        std::string value = assignment.substr(eqPos + 1);
-        envManager_.setVariable(name, value);
+    if (!hasWord) {
+        errorMessage = "redirection without a command";
+        return false;
     }
+    return true;
 }
 
-std::string Parser::resolveValue(const Token& token) {
-    if (token.type == TokenType::QUOTED_SINGLE) {
-        return token.value;
-    }
-
-    if (token.type == TokenType::QUOTED_DOUBLE) {
-        std::string result = token.value;
-        size_t pos = 0;
-        while ((pos = result.find('$', pos)) != std::string::npos) {
-            size_t end = pos + 1;
-
-            // Special case: $? (exit code variable)
-            if (end < result.length() && result[end] == '?') {
-                end++;
-                std::string varName = "?";
-                std::string varValue = envManager_.getVariable(varName);
-                result.replace(pos, end - pos, varValue);
-                pos += varValue.length();
-                continue;
-            }
-
-            // Regular variables
-            while (end < result.length() &&
-                   (std::isalnum(result[end]) || result[end] == '_')) {
-                end++;
-            }
-
-            if (end > pos + 1) {
-                std::string varName = result.substr(pos + 1, end - pos - 1);
-                std::string varValue = envManager_.getVariable(varName);
-                result.replace(pos, end - pos, varValue);
-                pos += varValue.length();
-            } else {
-                pos++;
-            }
+std::string Parser::jobText(const std::vector<TokenView>& tokens) {
+    std::string text;
+    for (const auto& token : tokens) {
+        if (!text.empty()) {
+            text += ' ';
+        }
+        if (token.type == TokenType::QUOTED_SINGLE) {
+            text += "'" + token.str() + "'";
+        } else if (token.type == TokenType::QUOTED_DOUBLE) {
+            text += "\"" + token.str() + "\"";
+        } else {
+            text += token.value;
         }
-        return result;
     }
+    return text;
+}
+
+bool Parser::isAssignment(const std::vector<TokenView>& tokens) {
+    return tokens.size() == 1 && tokens[0].type == TokenType::ASSIGNMENT;
+}
 
-    if (token.type == TokenType::WORD && !token.value.empty() &&
-        token.value[0] == '$') {
-        std::string varName = token.value.substr(1);
-        return envManager_.getVariable(varName);
+Word Parser::compileWord(const TokenView& token) {
+    if (token.type == TokenType::QUOTED_DOUBLE ||
+        (token.type == TokenType::WORD &&
+         token.value.find('$') != std::string_view::npos)) {
+        return VariableExpander::compile(token.value);
     }
 
-    return token.value;
+    Word word;
+    word.appendLiteral(token.value);
+    return word;
 }
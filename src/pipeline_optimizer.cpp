@@ -0,0 +1,228 @@
+#include "pipeline_optimizer.h"
+
+#include <algorithm>
+#include <memory>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "commands/abstract_command.h"
+#include "commands/builtin_command.h"
+#include "environment_manager.h"
+#include "ring_buffer.h"
+
+namespace {
+
+bool isStandard(const StagePlan& stage, const char* name) {
+    return stage.words[0].isLiteral() &&
+           stage.builtin == CommandFactory::standardBuiltin(name);
+}
+
+std::string literalText(const Word& word) {
+    std::string text;
+    for (const auto& segment : word.segments()) {
+        text += segment.text;
+    }
+    return text;
+}
+
+void appendWord(Word& to, const Word& word) {
+    for (const auto& segment : word.segments()) {
+        if (segment.kind == WordSegment::Kind::Literal) {
+            to.appendLiteral(segment.text);
+        } else {
+            to.appendVariable(segment.text);
+        }
+    }
+}
+
+// True if the stage's stdin is left to the pipeline.
+bool readsPipe(const StagePlan& stage) {
+    for (const auto& redirect : stage.redirects) {
+        if (redirect.fd == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Hands the input of stage index over to the next stage and drops it.
+void foldIntoNext(std::vector<StagePlan>& stages, size_t index,
+                  RedirectPlan input) {
+    auto& redirects = stages[index + 1].redirects;
+    redirects.insert(redirects.begin(), std::move(input));
+    stages.erase(stages.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+// Input redirection reading the file with the given (expanded) name.
+RedirectPlan fileInput(const std::string& path) {
+    Word target;
+    target.appendLiteral(path);
+    return {Redirection::Kind::Input, 0, std::move(target)};
+}
+
+}  // namespace
+
+const std::array<PipelineOptimizer::Rule, 3> PipelineOptimizer::kRules = {{
+    {"cat-file", &PipelineOptimizer::catFile},
+    {"echo-text", &PipelineOptimizer::echoText},
+    {"drop-cat", &PipelineOptimizer::dropCat},
+}};
+
+PipelineOptimizer::PipelineOptimizer(const CommandFactory& factory)
+    : factory_(factory) {}
+
+std::vector<size_t> PipelineOptimizer::optimize(
+    std::vector<StagePlan>& stages, const EnvironmentSnapshot& snapshot,
+    bool background) const {
+    Context context{snapshot, background};
+    std::vector<size_t> positions(stages.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        positions[i] = i;
+    }
+    std::vector<size_t> removed;
+
+    // Every rule removes a stage, so this ends.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < stages.size() && !changed; i++) {
+            for (const Rule& rule : kRules) {
+                if ((this->*rule.apply)(stages, i, context)) {
+                    removed.push_back(positions[i]);
+                    positions.erase(positions.begin() +
+                                    static_cast<std::ptrdiff_t>(i));
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::sort(removed.begin(), removed.end());
+    return removed;
+}
+
+bool PipelineOptimizer::catFile(std::vector<StagePlan>& stages, size_t index,
+                                const Context& context) const {
+    const StagePlan& stage = stages[index];
+    if (!isStandard(stage, "cat") || !canReceive(stages, index + 1)) {
+        return false;
+    }
+
+    // `cat FILE` or `cat < FILE`; `cat -` copies its input.
+    std::string path;
+    if (stage.words.size() == 2 && stage.redirects.empty()) {
+        const Word& file = stage.words[1];
+        if (file.isLiteral() && literalText(file) == "-") {
+            return false;
+        }
+        path = file.bind(context.snapshot);
+    } else if (stage.words.size() == 1 && stage.redirects.size() == 1 &&
+               stage.redirects[0].kind == Redirection::Kind::Input) {
+        path = stage.redirects[0].target.bind(context.snapshot);
+    } else {
+        return false;
+    }
+    if (!canFoldFile(path, context)) {
+        return false;
+    }
+
+    foldIntoNext(stages, index, fileInput(path));
+    return true;
+}
+
+bool PipelineOptimizer::echoText(std::vector<StagePlan>& stages, size_t index,
+                                 const Context&) const {
+    const StagePlan& stage = stages[index];
+    if (!isStandard(stage, "echo") || !stage.redirects.empty() ||
+        !canReceive(stages, index + 1)) {
+        return false;
+    }
+
+    // Same text as echo prints: the arguments separated by spaces (the
+    // newline is added when the text is read). Like echo, it always
+    // succeeds.
+    Word text;
+    for (size_t i = 1; i < stage.words.size(); i++) {
+        if (i > 1) {
+            text.appendLiteral(" ");
+        }
+        appendWord(text, stage.words[i]);
+    }
+
+    foldIntoNext(stages, index, {Redirection::Kind::Text, 0, std::move(text)});
+    return true;
+}
+
+bool PipelineOptimizer::dropCat(std::vector<StagePlan>& stages, size_t index,
+                                const Context& context) const {
+    // The status of a cat between two stages depends on its reader.
+    const StagePlan& stage = stages[index];
+    if (!context.background || !isStandard(stage, "cat") ||
+        stage.words.size() != 1 || !canReceive(stages, index + 1)) {
+        return false;
+    }
+
+    // Text left by echo-text moves on; a leading cat reading stdin stays.
+    if (stage.redirects.size() == 1 &&
+        stage.redirects[0].kind == Redirection::Kind::Text) {
+        foldIntoNext(stages, index, stage.redirects[0]);
+        return true;
+    }
+    if (index == 0 || !stage.redirects.empty()) {
+        return false;
+    }
+    stages.erase(stages.begin() + static_cast<std::ptrdiff_t>(index));
+    return true;
+}
+
+bool PipelineOptimizer::canReceive(const std::vector<StagePlan>& stages,
+                                   size_t index) const {
+    if (index >= stages.size()) {
+        return false;
+    }
+    const StagePlan& stage = stages[index];
+    if (!readsPipe(stage)) {
+        return false;
+    }
+    if (stages.size() > 2) {
+        return true;
+    }
+
+    // The receiving stage would run on its own.
+    if (!stage.words[0].isLiteral()) {
+        return false;
+    }
+    if (stage.builtin == kNoBuiltin) {
+        return true;
+    }
+    auto command = factory_.createCommand(
+        stage.builtin, literalText(stage.words[0]), {});
+    auto builtin = dynamic_cast<BuiltinCommand*>(command.get());
+    return builtin && !builtin->modifiesInterpreterState();
+}
+
+bool PipelineOptimizer::canFoldFile(const std::string& path,
+                                    const Context& context) {
+#ifdef _WIN32
+    return false;
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    bool regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    close(fd);
+
+    // A file filling at most the pipe is written in full whatever the
+    // reader does, so cat would have succeeded.
+    return regular && (context.background ||
+                       static_cast<size_t>(st.st_size) <=
+                           RingBuffer::kDefaultCapacity);
+#endif
+}
@@ -1,6 +1,11 @@
 #include "process_manager.h"
 
+#include "command_hash_table.h"
+#include "event_loop.h"
+#include "stream_pump.h"
+
 #include <cstdlib>
+#include <iostream>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -8,16 +13,95 @@
 #include <sstream>
 #else
 #include <signal.h>
+#include <spawn.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
 #include <vector>
 #endif
 
+#ifndef _WIN32
+namespace {
+
+// Runs files the kernel cannot execute itself.
+const char* const kShell = "/bin/sh";
+
+bool isExecError(int err) {
+    return err == ENOENT || err == EACCES || err == ENOEXEC ||
+           err == ENOTDIR || err == ELOOP || err == ENAMETOOLONG;
+}
+
+// Value of PATH in a "NAME=value" array, or empty if it has none.
+std::string findSearchPath(char* const envp[]) {
+    for (char* const* env = envp; env && *env; ++env) {
+        if (std::strncmp(*env, "PATH=", 5) == 0) {
+            return *env + 5;
+        }
+    }
+    return "";
+}
+
+}  // namespace
+
+pid_t ProcessManager::spawnExecutable(const std::string& path,
+                                      char* const argv[], char* const envp[],
+                                      int inFd, int outFd, int errFd) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (inFd >= 0 && inFd != STDIN_FILENO) {
+        posix_spawn_file_actions_adddup2(&actions, inFd, STDIN_FILENO);
+    }
+    if (outFd >= 0 && outFd != STDOUT_FILENO) {
+        posix_spawn_file_actions_adddup2(&actions, outFd, STDOUT_FILENO);
+    }
+    if (errFd >= 0 && errFd != STDERR_FILENO) {
+        posix_spawn_file_actions_adddup2(&actions, errFd, STDERR_FILENO);
+    }
+
+    // Threads running builtins block SIGPIPE; children must start with a
+    // clean mask and default SIGPIPE handling.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setflags(&attr,
+                             POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    pid_t pid = -1;
+    int rc = posix_spawn(&pid, path.c_str(), &actions, &attr, argv, envp);
+    if (rc == ENOEXEC) {
+        std::vector<char*> shellArgv = {const_cast<char*>(kShell),
+                                        const_cast<char*>(path.c_str())};
+        for (size_t i = 1; argv[0] && argv[i]; i++) {
+            shellArgv.push_back(argv[i]);
+        }
+        shellArgv.push_back(nullptr);
+        rc = posix_spawn(&pid, kShell, &actions, &attr, shellArgv.data(),
+                         envp);
+    }
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (rc != 0) {
+        errno = rc;
+        return -1;
+    }
+    return pid;
+}
+#endif
+
 int ProcessManager::executeExternal(
     const std::string& program, const std::vector<std::string>& args,
-    const std::map<std::string, std::string>& environment, std::istream& input,
-    std::ostream& output, std::ostream& error) {
+    char* const envp[], Source& input, Sink& output, Sink& error) {
+    output.flush();
+    error.flush();
+
 #ifdef _WIN32
     std::string cmdLine = program;
     for (const auto& arg : args) {
@@ -33,8 +117,9 @@ int ProcessManager::executeExternal(
     si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
 
     std::string envBlock;
-    for (const auto& [key, value] : environment) {
-        envBlock += key + "=" + value + '\0';
+    for (char* const* env = envp; env && *env; ++env) {
+        envBlock += *env;
+        envBlock += '\0';
     }
     if (!envBlock.empty()) {
         envBlock += '\0';
@@ -46,7 +131,7 @@ int ProcessManager::executeExternal(
         &si, &pi);
 
     if (!success) {
-        error << "Failed to execute: " << program << std::endl;
+        error.write("Failed to execute: " + program + "\n");
         return 1;
     }
 
@@ -60,33 +145,40 @@ int ProcessManager::executeExternal(
 
     return static_cast<int>(exitCode);
 #else
-    pid_t pid = fork();
-
-    if (pid < 0) {
-        error << "Fork failed" << std::endl;
+    // Streams backed by descriptors are handed to the program as they are;
+    // anything else is connected through a pipe pumped while it runs.
+    EventLoop loop;
+    StreamPump pump(loop);
+    int inFd = pump.inputFor(input);
+    int outFd = pump.outputFor(output);
+    int errFd = pump.outputFor(error);
+    if (inFd < 0 || outFd < 0 || errFd < 0) {
+        error.write(std::string("Failed to create pipes: ") +
+                    strerror(errno) + "\n");
         return 1;
     }
 
-    if (pid == 0) {
-        for (const auto& [key, value] : environment) {
-            setenv(key.c_str(), value.c_str(), 1);
-        }
+    pid_t pid = spawnProcess(program, args, envp, inFd, outFd, errFd);
 
-        std::vector<char*> argv;
-        argv.push_back(const_cast<char*>(program.c_str()));
-        for (const auto& arg : args) {
-            argv.push_back(const_cast<char*>(arg.c_str()));
+    if (pid < 0) {
+        if (isExecError(errno)) {
+            error.write("Failed to execute: " + program + "\n");
+            return 127;
         }
-        argv.push_back(nullptr);
-
-        execvp(program.c_str(), argv.data());
+        error.write(std::string("Fork failed: ") + strerror(errno) + "\n");
+        return 1;
+    }
 
-        std::cerr << "Failed to execute: " << program << std::endl;
-        exit(127);
+    // The program's output is complete once it closes its end of the
+    // pipes, normally when it exits.
+    pump.start();
+    while (!pump.finished()) {
+        loop.runOnce(-1);
     }
 
     int status;
-    waitpid(pid, &status, 0);
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
 
     if (WIFEXITED(status)) {
         return WEXITSTATUS(status);
@@ -97,7 +189,58 @@ int ProcessManager::executeExternal(
 }
 
 #ifndef _WIN32
-pid_t ProcessManager::forkProcess() { return fork(); }
+pid_t ProcessManager::spawnProcess(
+    const std::string& program, const std::vector<std::string>& args,
+    char* const envp[], int inFd, int outFd, int errFd) {
+    // Everything the child needs is built here, so the spawn itself only
+    // has to duplicate descriptors and exec.
+    std::string searchPath = findSearchPath(envp);
+
+    CommandHashTable& hashTable = CommandHashTable::getInstance();
+    std::string path = hashTable.find(program, searchPath);
+    if (path.empty()) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(program.c_str()));
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = spawnExecutable(path, argv.data(), envp, inFd, outFd, errFd);
+    if (pid < 0 && isExecError(errno) && path != program) {
+        // The remembered path may be stale (program moved or removed):
+        // forget it and search PATH once more.
+        hashTable.remove(program);
+        path = hashTable.find(program, searchPath);
+        if (path.empty()) {
+            errno = ENOENT;
+            return -1;
+        }
+        pid = spawnExecutable(path, argv.data(), envp, inFd, outFd, errFd);
+        if (pid < 0) {
+            int savedErrno = errno;
+            hashTable.remove(program);
+            errno = savedErrno;
+        }
+    }
+    return pid;
+}
+
+pid_t ProcessManager::forkProcess() {
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Signals the interpreter takes through its event loop are
+        // blocked; the child must get them again.
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigprocmask(SIG_SETMASK, &signals, nullptr);
+    }
+    return pid;
+}
 
 void ProcessManager::waitForProcesses(const std::vector<pid_t>& pids,
                                       std::vector<int>& exitCodes) {
@@ -0,0 +1,86 @@
+#include "process_supervisor.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "io_redirector.h"
+
+ProcessSupervisor::ProcessSupervisor() {
+    if (IORedirector::openPipe(wakeFds_)) {
+        for (int fd : wakeFds_) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+    } else {
+        wakeFds_[0] = wakeFds_[1] = -1;
+    }
+}
+
+ProcessSupervisor::~ProcessSupervisor() {
+    for (int fd : wakeFds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+size_t ProcessSupervisor::add(pid_t pid) {
+    size_t index = pids_.size();
+    pids_.push_back(pid);
+    done_.push_back(false);
+    running_++;
+
+    loop_.watchChild(pid, [this, index](int exitCode) {
+        done_[index] = true;
+        running_--;
+        if (onExit_ && (*onExit_)(index, exitCode) && !tornDown_) {
+            terminateRunning();
+        }
+    });
+    return index;
+}
+
+void ProcessSupervisor::wait(const ExitHandler& onExit) {
+    onExit_ = &onExit;
+    if (wakeFds_[0] >= 0) {
+        loop_.watch(wakeFds_[0], EventLoop::kReadable, [this](uint32_t) {
+            char buffer[64];
+            while (read(wakeFds_[0], buffer, sizeof(buffer)) > 0) {
+            }
+        });
+    }
+
+    while (running_ > 0) {
+        if (!tornDown_ &&
+            teardownRequested_.load(std::memory_order_acquire)) {
+            terminateRunning();
+        }
+        // Without the wake pipe a teardown request is noticed on timeout.
+        loop_.runOnce(wakeFds_[0] >= 0 ? -1 : 10);
+    }
+
+    loop_.unwatch(wakeFds_[0]);
+    onExit_ = nullptr;
+}
+
+void ProcessSupervisor::requestTeardown() {
+    teardownRequested_.store(true, std::memory_order_release);
+    if (wakeFds_[1] >= 0) {
+        char byte = 0;
+        ssize_t ignored = write(wakeFds_[1], &byte, 1);
+        (void)ignored;
+    }
+}
+
+void ProcessSupervisor::terminateRunning() {
+    // Children not reaped yet still own their pid, so it cannot have been
+    // reused by an unrelated process.
+    tornDown_ = true;
+    for (size_t i = 0; i < pids_.size(); i++) {
+        if (!done_[i]) {
+            kill(pids_[i], SIGTERM);
+        }
+    }
+}
+#endif
@@ -0,0 +1,101 @@
+#include "ring_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kRingSourceBlockSize = 16 * 1024;
+
+}  // namespace
+
+RingBuffer::RingBuffer(size_t capacity) : buffer_(capacity) {}
+
+bool RingBuffer::write(const char* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (size > 0) {
+        notFull_.wait(lock, [this] {
+            return readerClosed_ || size_ < buffer_.size();
+        });
+        if (readerClosed_) {
+            return false;
+        }
+
+        size_t tail = (head_ + size_) % buffer_.size();
+        size_t chunk = std::min(size, buffer_.size() - size_);
+        chunk = std::min(chunk, buffer_.size() - tail);
+        std::memcpy(buffer_.data() + tail, data, chunk);
+        size_ += chunk;
+        data += chunk;
+        size -= chunk;
+        notEmpty_.notify_one();
+    }
+    return true;
+}
+
+size_t RingBuffer::read(char* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notEmpty_.wait(lock, [this] { return writerClosed_ || size_ > 0; });
+
+    size_t copied = 0;
+    while (copied < size && size_ > 0) {
+        size_t chunk = std::min(size - copied, size_);
+        chunk = std::min(chunk, buffer_.size() - head_);
+        std::memcpy(data + copied, buffer_.data() + head_, chunk);
+        head_ = (head_ + chunk) % buffer_.size();
+        size_ -= chunk;
+        copied += chunk;
+    }
+    if (copied > 0) {
+        notFull_.notify_one();
+    }
+    return copied;
+}
+
+void RingBuffer::closeWriter() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    writerClosed_ = true;
+    notEmpty_.notify_all();
+}
+
+void RingBuffer::closeReader() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    readerClosed_ = true;
+    notFull_.notify_all();
+}
+
+RingSource::RingSource(RingBuffer& ring)
+    : ring_(ring), buffer_(kRingSourceBlockSize) {}
+
+RingSource::~RingSource() { close(); }
+
+bool RingSource::next(const char*& data, size_t& size) {
+    if (closed_) {
+        return false;
+    }
+    size = ring_.read(buffer_.data(), buffer_.size());
+    data = buffer_.data();
+    return size > 0;
+}
+
+void RingSource::close() {
+    if (!closed_) {
+        closed_ = true;
+        ring_.closeReader();
+    }
+}
+
+RingSink::RingSink(RingBuffer& ring) : ring_(ring) {}
+
+RingSink::~RingSink() { close(); }
+
+bool RingSink::write(const char* data, size_t size) {
+    return !closed_ && ring_.write(data, size);
+}
+
+void RingSink::close() {
+    if (!closed_) {
+        closed_ = true;
+        ring_.closeWriter();
+    }
+}
@@ -0,0 +1,262 @@
+#include "source_sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "fd_transfer.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t kBlockSize = 64 * 1024;
+constexpr size_t kStreambufSize = 16 * 1024;
+
+#ifdef _WIN32
+long readFd(int fd, char* data, size_t size) {
+    return _read(fd, data, static_cast<unsigned int>(size));
+}
+
+long writeFd(int fd, const char* data, size_t size) {
+    return _write(fd, data, static_cast<unsigned int>(size));
+}
+
+void closeFd(int fd) { _close(fd); }
+#else
+long readFd(int fd, char* data, size_t size) {
+    ssize_t n;
+    do {
+        n = read(fd, data, size);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+long writeFd(int fd, const char* data, size_t size) {
+    ssize_t n;
+    do {
+        n = write(fd, data, size);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+void closeFd(int fd) { ::close(fd); }
+#endif
+
+}  // namespace
+
+StreamSource::StreamSource(std::istream& stream)
+    : stream_(stream), buffer_(kBlockSize) {}
+
+bool StreamSource::next(const char*& data, size_t& size) {
+    std::streambuf* in = stream_.rdbuf();
+    const auto capacity = static_cast<std::streamsize>(buffer_.size());
+
+    std::streamsize available = in ? in->in_avail() : -1;
+    std::streamsize n = 0;
+
+    if (available > 0) {
+        n = in->sgetn(buffer_.data(), std::min(available, capacity));
+    } else if (available == 0) {
+        // Nothing buffered (stdin synced with stdio never exposes its
+        // buffer): take one line so a downstream reader is not kept
+        // waiting for a full block.
+        int ch;
+        while (n < capacity &&
+               (ch = in->sbumpc()) != std::char_traits<char>::eof()) {
+            buffer_[n++] = static_cast<char>(ch);
+            if (ch == '\n') {
+                break;
+            }
+        }
+    }
+
+    if (n <= 0) {
+        stream_.setstate(std::ios::eofbit);
+        return false;
+    }
+
+    data = buffer_.data();
+    size = static_cast<size_t>(n);
+    return true;
+}
+
+StreamSink::StreamSink(std::ostream& stream) : stream_(stream) {}
+
+bool StreamSink::write(const char* data, size_t size) {
+    return static_cast<bool>(
+        stream_.write(data, static_cast<std::streamsize>(size)));
+}
+
+bool StreamSink::flush() { return static_cast<bool>(stream_.flush()); }
+
+int StreamSink::fd() const { return FdTransfer::streamDescriptor(stream_); }
+
+FdSource::FdSource(int fd, bool owned) : fd_(fd), owned_(owned) {}
+
+FdSource::~FdSource() { close(); }
+
+bool FdSource::next(const char*& data, size_t& size) {
+    if (fd_ < 0 || failed_) {
+        return false;
+    }
+    if (buffer_.empty()) {
+        buffer_.resize(kBlockSize);
+    }
+
+    long n = readFd(fd_, buffer_.data(), buffer_.size());
+    if (n < 0) {
+        failed_ = true;
+        return false;
+    }
+    if (n == 0) {
+        return false;
+    }
+
+    data = buffer_.data();
+    size = static_cast<size_t>(n);
+    return true;
+}
+
+void FdSource::close() {
+    if (owned_ && fd_ >= 0) {
+        closeFd(fd_);
+    }
+    fd_ = -1;
+}
+
+FdSink::FdSink(int fd, bool owned) : fd_(fd), owned_(owned) {}
+
+FdSink::~FdSink() { close(); }
+
+bool FdSink::write(const char* data, size_t size) {
+    if (fd_ < 0) {
+        return false;
+    }
+    if (buffer_.empty()) {
+        buffer_.resize(kBlockSize);
+    }
+
+    // Large writes go straight through instead of being chopped up.
+    if (size >= buffer_.size()) {
+        return flush() && writeAll(data, size);
+    }
+    if (used_ + size > buffer_.size() && !flush()) {
+        return false;
+    }
+    std::memcpy(buffer_.data() + used_, data, size);
+    used_ += size;
+    return true;
+}
+
+bool FdSink::flush() {
+    if (used_ == 0) {
+        return true;
+    }
+    size_t pending = used_;
+    used_ = 0;
+    return writeAll(buffer_.data(), pending);
+}
+
+void FdSink::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    flush();
+    if (owned_) {
+        closeFd(fd_);
+    }
+    fd_ = -1;
+}
+
+bool FdSink::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        long n = writeFd(fd_, data, size);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+StringSource::StringSource(std::string text) : text_(std::move(text)) {}
+
+bool StringSource::next(const char*& data, size_t& size) {
+    if (consumed_ || text_.empty()) {
+        return false;
+    }
+    consumed_ = true;
+    data = text_.data();
+    size = text_.size();
+    return true;
+}
+
+bool StringSink::write(const char* data, size_t size) {
+    text_.append(data, size);
+    return true;
+}
+
+SourceStreambuf::SourceStreambuf(Source& source) : source_(source) {}
+
+SourceStreambuf::int_type SourceStreambuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    const char* data;
+    size_t size;
+    if (!source_.next(data, size)) {
+        return traits_type::eof();
+    }
+
+    // The block stays valid until the next call to next(), which only
+    // happens once the get area is exhausted.
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+    return traits_type::to_int_type(*gptr());
+}
+
+SinkStreambuf::SinkStreambuf(Sink& sink)
+    : sink_(sink), buffer_(kStreambufSize) {
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+SinkStreambuf::~SinkStreambuf() { sync(); }
+
+SinkStreambuf::int_type SinkStreambuf::overflow(int_type ch) {
+    if (!flushPutArea()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize SinkStreambuf::xsputn(const char* data,
+                                      std::streamsize size) {
+    if (size >= static_cast<std::streamsize>(buffer_.size())) {
+        if (!flushPutArea() || !sink_.write(data, static_cast<size_t>(size))) {
+            return 0;
+        }
+        return size;
+    }
+    return std::streambuf::xsputn(data, size);
+}
+
+int SinkStreambuf::sync() {
+    return flushPutArea() && sink_.flush() ? 0 : -1;
+}
+
+bool SinkStreambuf::flushPutArea() {
+    size_t pending = pptr() - pbase();
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    return pending == 0 || sink_.write(buffer_.data(), pending);
+}
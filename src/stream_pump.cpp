@@ -0,0 +1,197 @@
+#include "stream_pump.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "fd_transfer.h"
+#include "io_redirector.h"
+
+namespace {
+
+// A child that exits without reading its input must not kill the
+// interpreter with SIGPIPE: the signal is blocked around the write, and
+// one raised by it is taken off the pending set again.
+ssize_t writeWithoutSigpipe(int fd, const char* data, size_t size) {
+    sigset_t sigpipe;
+    sigset_t previous;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, &previous);
+
+    ssize_t n = write(fd, data, size);
+    int savedErrno = errno;
+
+    if (n < 0 && savedErrno == EPIPE && !sigismember(&previous, SIGPIPE)) {
+        sigset_t pending;
+        sigpending(&pending);
+        if (sigismember(&pending, SIGPIPE)) {
+            int signo;
+            sigwait(&sigpipe, &signo);
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+    errno = savedErrno;
+    return n;
+}
+
+}  // namespace
+
+StreamPump::StreamPump(EventLoop& loop) : loop_(loop) {}
+
+StreamPump::~StreamPump() {
+    for (auto& stream : streams_) {
+        if (stream->fd >= 0) {
+            loop_.unwatch(stream->fd);
+            close(stream->fd);
+        }
+        if (stream->childFd >= 0) {
+            close(stream->childFd);
+        }
+    }
+}
+
+int StreamPump::inputFor(Source& source) {
+    int fd = source.fd();
+    if (fd < 0) {
+        if (auto streamSource = dynamic_cast<StreamSource*>(&source)) {
+            fd = FdTransfer::streamDescriptor(streamSource->stream());
+        }
+    }
+    if (fd >= 0) {
+        return fd;
+    }
+
+    int fds[2];
+    if (!IORedirector::openPipe(fds)) {
+        return -1;
+    }
+    auto stream = std::make_unique<Stream>();
+    stream->fd = fds[1];
+    stream->childFd = fds[0];
+    stream->source = &source;
+    streams_.push_back(std::move(stream));
+    return fds[0];
+}
+
+int StreamPump::outputFor(Sink& sink) {
+    int fd = sink.fd();
+    if (fd >= 0) {
+        return fd;
+    }
+
+    int fds[2];
+    if (!IORedirector::openPipe(fds)) {
+        return -1;
+    }
+    auto stream = std::make_unique<Stream>();
+    stream->fd = fds[0];
+    stream->childFd = fds[1];
+    stream->sink = &sink;
+    streams_.push_back(std::move(stream));
+    return fds[1];
+}
+
+void StreamPump::start() {
+    for (auto& owned : streams_) {
+        Stream* stream = owned.get();
+        if (stream->childFd >= 0) {
+            close(stream->childFd);
+            stream->childFd = -1;
+        }
+        if (stream->fd < 0) {
+            continue;
+        }
+        if (stream->sink && buffer_.empty()) {
+            buffer_.resize(FdTransfer::kBlockSize);
+        }
+
+        // Never block on one pipe while another one needs service.
+        fcntl(stream->fd, F_SETFL, fcntl(stream->fd, F_GETFL) | O_NONBLOCK);
+        open_++;
+        bool watched = loop_.watch(
+            stream->fd,
+            stream->source ? EventLoop::kWritable : EventLoop::kReadable,
+            [this, stream](uint32_t) {
+                if (stream->source) {
+                    feed(*stream);
+                } else {
+                    drain(*stream);
+                }
+            });
+        if (!watched) {
+            close(stream->fd);
+            stream->fd = -1;
+            open_--;
+        }
+    }
+}
+
+void StreamPump::closeAll() {
+    // Nothing is unwatched: a forked child shares the loop's epoll
+    // instance with its parent.
+    for (auto& stream : streams_) {
+        if (stream->fd >= 0) {
+            close(stream->fd);
+        }
+        if (stream->childFd >= 0) {
+            close(stream->childFd);
+        }
+    }
+    streams_.clear();
+    open_ = 0;
+}
+
+void StreamPump::feed(Stream& stream) {
+    while (true) {
+        if (stream.pendingSize == 0 &&
+            !stream.source->next(stream.pending, stream.pendingSize)) {
+            finish(stream);
+            return;
+        }
+
+        ssize_t n =
+            writeWithoutSigpipe(stream.fd, stream.pending, stream.pendingSize);
+        if (n >= 0) {
+            stream.pending += n;
+            stream.pendingSize -= static_cast<size_t>(n);
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            // EPIPE: the children stopped reading.
+            finish(stream);
+        }
+        return;
+    }
+}
+
+void StreamPump::drain(Stream& stream) {
+    ssize_t n = read(stream.fd, buffer_.data(), buffer_.size());
+    if (n > 0) {
+        if (!stream.sink->write(buffer_.data(), static_cast<size_t>(n))) {
+            // Like a reader going away: the writers get EPIPE.
+            finish(stream);
+        }
+        return;
+    }
+    if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+    }
+    stream.sink->flush();
+    finish(stream);
+}
+
+void StreamPump::finish(Stream& stream) {
+    loop_.unwatch(stream.fd);
+    close(stream.fd);
+    stream.fd = -1;
+    open_--;
+}
+#endif
@@ -0,0 +1,195 @@
+#include "text_counter.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TEXT_COUNTER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+inline bool isSpace(unsigned char ch) {
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+// Each kernel counts newlines and word starts in [p, end) and returns the
+// position it stopped at; the scalar kernel finishes the tail.
+struct KernelState {
+    size_t lines = 0;
+    size_t words = 0;
+    bool inWord = false;
+};
+
+void countScalar(const unsigned char* p, const unsigned char* end,
+                 KernelState& state) {
+    for (; p < end; ++p) {
+        unsigned char ch = *p;
+        state.lines += (ch == '\n');
+        bool space = isSpace(ch);
+        state.words += (!space && !state.inWord);
+        state.inWord = !space;
+    }
+}
+
+#ifdef TEXT_COUNTER_X86
+__attribute__((target("sse2"))) const unsigned char* countSSE2(
+    const unsigned char* p, const unsigned char* end, KernelState& state) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i blank = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i ctlRange = _mm_set1_epi8('\r' - '\t');
+
+    // Bit i set when the byte before position i is whitespace.
+    uint32_t carry = state.inWord ? 0 : 1;
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i shifted = _mm_sub_epi8(v, tab);
+        __m128i ctl =
+            _mm_cmpeq_epi8(_mm_min_epu8(shifted, ctlRange), shifted);
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, blank), ctl);
+
+        auto spaceMask = static_cast<uint32_t>(_mm_movemask_epi8(space));
+        auto lineMask = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)));
+        uint32_t starts = ~spaceMask & ((spaceMask << 1) | carry) & 0xFFFFu;
+
+        state.lines += __builtin_popcount(lineMask);
+        state.words += __builtin_popcount(starts);
+        carry = (spaceMask >> 15) & 1u;
+    }
+    state.inWord = carry == 0;
+    return p;
+}
+
+__attribute__((target("avx2"))) const unsigned char* countAVX2(
+    const unsigned char* p, const unsigned char* end, KernelState& state) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i blank = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i ctlRange = _mm256_set1_epi8('\r' - '\t');
+
+    uint64_t carry = state.inWord ? 0 : 1;
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i shifted = _mm256_sub_epi8(v, tab);
+        __m256i ctl =
+            _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, ctlRange), shifted);
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(v, blank), ctl);
+
+        auto spaceMask = static_cast<uint32_t>(_mm256_movemask_epi8(space));
+        auto lineMask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)));
+        uint64_t starts = ~static_cast<uint64_t>(spaceMask) &
+                          ((static_cast<uint64_t>(spaceMask) << 1) | carry) &
+                          0xFFFFFFFFull;
+
+        state.lines += __builtin_popcount(lineMask);
+        state.words += __builtin_popcountll(starts);
+        carry = (spaceMask >> 31) & 1u;
+    }
+    state.inWord = carry == 0;
+    return p;
+}
+#endif
+
+}  // namespace
+
+TextCounter::TextCounter() : kernel_(bestKernel()) {}
+
+TextCounter::TextCounter(Kernel kernel)
+    : kernel_(isSupported(kernel) ? kernel : Kernel::Scalar) {}
+
+void TextCounter::update(const char* data, size_t size) {
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+
+    KernelState state;
+    state.inWord = inWord_;
+
+#ifdef TEXT_COUNTER_X86
+    if (kernel_ == Kernel::AVX2) {
+        p = countAVX2(p, end, state);
+    } else if (kernel_ == Kernel::SSE2) {
+        p = countSSE2(p, end, state);
+    }
+#endif
+    countScalar(p, end, state);
+
+    stats_.lines += state.lines;
+    stats_.words += state.words;
+    stats_.bytes += size;
+    inWord_ = state.inWord;
+}
+
+bool TextCounter::isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+#ifdef TEXT_COUNTER_X86
+        case Kernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+TextCounter::Kernel TextCounter::bestKernel() {
+    static const Kernel best = [] {
+        if (isSupported(Kernel::AVX2)) {
+            return Kernel::AVX2;
+        }
+        if (isSupported(Kernel::SSE2)) {
+            return Kernel::SSE2;
+        }
+        return Kernel::Scalar;
+    }();
+    return best;
+}
+
+TextStats TextCounter::countParallel(const char* data, size_t size,
+                                     unsigned threads) {
+    if (threads <= 1 || size < threads) {
+        TextCounter counter;
+        counter.update(data, size);
+        return counter.stats();
+    }
+
+    std::vector<TextStats> partial(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    size_t chunk = size / threads;
+    for (unsigned i = 0; i < threads; i++) {
+        size_t begin = i * chunk;
+        size_t end = (i + 1 == threads) ? size : begin + chunk;
+        workers.emplace_back([&partial, data, begin, end, i] {
+            TextCounter counter;
+            counter.update(data + begin, end - begin);
+            partial[i] = counter.stats();
+        });
+    }
+
+    TextStats total;
+    for (unsigned i = 0; i < threads; i++) {
+        workers[i].join();
+        total.lines += partial[i].lines;
+        total.words += partial[i].words;
+        total.bytes += partial[i].bytes;
+
+        // Every chunk starts outside a word, so a word running across the
+        // boundary was counted by both neighbours.
+        size_t boundary = i * chunk;
+        if (i > 0 &&
+            !isSpace(static_cast<unsigned char>(data[boundary - 1])) &&
+            !isSpace(static_cast<unsigned char>(data[boundary]))) {
+            total.words--;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,87 @@
+#include "variable_expander.h"
+
+#include <cctype>
+#include <vector>
+
+#include "environment_manager.h"
+
+namespace {
+
+bool isNameChar(char ch) {
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+}
+
+// Calls onLiteral/onVariable for consecutive pieces of text; literal
+// pieces may be empty and adjacent literal pieces are not merged.
+template <typename OnLiteral, typename OnVariable>
+void scan(std::string_view text, OnLiteral onLiteral, OnVariable onVariable) {
+    size_t literalStart = 0;
+    size_t pos = 0;
+    while ((pos = text.find('$', pos)) != std::string_view::npos) {
+        size_t nameStart = pos + 1;
+        size_t nameEnd = nameStart;
+        size_t end = nameStart;
+
+        if (nameStart < text.size() && text[nameStart] == '?') {
+            nameEnd = end = nameStart + 1;
+        } else if (nameStart < text.size() && text[nameStart] == '{') {
+            size_t close = text.find('}', nameStart + 1);
+            if (close != std::string_view::npos && close > nameStart + 1) {
+                nameStart++;
+                nameEnd = close;
+                end = close + 1;
+            }
+        } else {
+            while (nameEnd < text.size() && isNameChar(text[nameEnd])) {
+                nameEnd++;
+            }
+            end = nameEnd;
+        }
+
+        if (nameEnd == nameStart) {
+            pos++;
+            continue;
+        }
+
+        onLiteral(text.substr(literalStart, pos - literalStart));
+        onVariable(text.substr(nameStart, nameEnd - nameStart));
+        literalStart = pos = end;
+    }
+    onLiteral(text.substr(literalStart));
+}
+
+}  // namespace
+
+Word VariableExpander::compile(std::string_view text) {
+    Word word;
+    scan(
+        text, [&](std::string_view literal) { word.appendLiteral(literal); },
+        [&](std::string_view name) { word.appendVariable(name); });
+    return word;
+}
+
+std::string VariableExpander::expand(std::string_view text,
+                                     const EnvironmentManager& envManager) {
+    // Collect views of all pieces first so the result is allocated once;
+    // the snapshot keeps the viewed values alive meanwhile.
+    auto snapshot = envManager.snapshot();
+    std::vector<std::string_view> pieces;
+    size_t size = 0;
+    scan(
+        text,
+        [&](std::string_view literal) {
+            pieces.push_back(literal);
+            size += literal.size();
+        },
+        [&](std::string_view variable) {
+            pieces.push_back(snapshot->get(variable));
+            size += pieces.back().size();
+        });
+
+    std::string result;
+    result.reserve(size);
+    for (auto piece : pieces) {
+        result += piece;
+    }
+    return result;
+}
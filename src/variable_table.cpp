@@ -0,0 +1,94 @@
+#include "variable_table.h"
+
+#include <utility>
+
+namespace {
+
+constexpr size_t kInitialSlots = 64;
+
+}  // namespace
+
+VariableTable::VariableTable() {
+    capacity_ = kInitialSlots;
+    for (size_t i = 0; i < capacity_; i += kChunkSlots) {
+        chunks_.push_back(std::make_shared<Chunk>());
+    }
+}
+
+uint64_t VariableTable::hashName(std::string_view name) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (char ch : name) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t VariableTable::findSlot(std::string_view name, uint64_t hash) const {
+    size_t mask = capacity_ - 1;
+    size_t index = static_cast<size_t>(hash) & mask;
+    // The table is at most half full, so an empty slot is always reached.
+    while (slot(index).used &&
+           (slot(index).hash != hash || slot(index).name != name)) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+VariableTable::Slot& VariableTable::mutableSlot(size_t index) {
+    // A chunk still shared with a copy is cloned before it changes. The
+    // count cannot grow behind our back: other owners are other tables.
+    std::shared_ptr<Chunk>& chunk = chunks_[index / kChunkSlots];
+    if (chunk.use_count() > 1) {
+        chunk = std::make_shared<Chunk>(*chunk);
+    }
+    return (*chunk)[index % kChunkSlots];
+}
+
+const std::string* VariableTable::find(std::string_view name) const {
+    const Slot& found = slot(findSlot(name, hashName(name)));
+    return found.used ? found.value.get() : nullptr;
+}
+
+void VariableTable::set(std::string_view name, std::string_view value) {
+    auto shared = std::make_shared<const std::string>(value);
+    uint64_t hash = hashName(name);
+    size_t index = findSlot(name, hash);
+    if (slot(index).used) {
+        mutableSlot(index).value = std::move(shared);
+        return;
+    }
+
+    if ((size_ + 1) * 2 > capacity_) {
+        grow();
+        index = findSlot(name, hash);
+    }
+
+    Slot& added = mutableSlot(index);
+    added.used = true;
+    added.hash = hash;
+    added.name.assign(name);
+    added.value = std::move(shared);
+    size_++;
+}
+
+void VariableTable::grow() {
+    std::vector<std::shared_ptr<Chunk>> old;
+    old.swap(chunks_);
+    capacity_ *= 2;
+    for (size_t i = 0; i < capacity_; i += kChunkSlots) {
+        chunks_.push_back(std::make_shared<Chunk>());
+    }
+
+    // Old chunks may be shared with copies: slots are copied, which only
+    // shares their values.
+    for (const auto& chunk : old) {
+        for (const auto& entry : *chunk) {
+            if (entry.used) {
+                Slot& moved = mutableSlot(findSlot(entry.name, entry.hash));
+                moved = entry;
+            }
+        }
+    }
+}
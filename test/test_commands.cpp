@@ -1,12 +1,18 @@
 #include <gtest/gtest.h>
 
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 
+#include "command_hash_table.h"
+#include "environment_manager.h"
 #include "commands/cat_command.h"
 #include "commands/echo_command.h"
 #include "commands/exit_command.h"
+#include "commands/hash_command.h"
+#include "commands/parallel_command.h"
 #include "commands/pwd_command.h"
+#include "commands/set_command.h"
 #include "commands/wc_command.h"
 
 TEST(CommandsTest, EchoCommand) {
@@ -140,3 +146,184 @@ TEST(CommandsTest, WcEmptyStdin) {
     EXPECT_EQ(ret, 0);
     EXPECT_EQ(output.str(), "0 0 0\n");
 }
+
+TEST(CommandsTest, CatFileIsByteExact) {
+    const std::string filename = "cat_byte_exact_test.txt";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "first\nsecond without newline";
+    }
+
+    CatCommand cmd(filename);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    int ret = cmd.execute(input, output, error);
+    std::remove(filename.c_str());
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "first\nsecond without newline");
+}
+
+TEST(CommandsTest, CatFromStdinKeepsMissingNewline) {
+    CatCommand cmd("");
+
+    std::istringstream input("no newline at end");
+    std::ostringstream output;
+    std::ostringstream error;
+
+    int ret = cmd.execute(input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "no newline at end");
+}
+
+TEST(CommandsTest, WcLargeFilePathMatchesStream) {
+    const std::string filename = "wc_parallel_test.txt";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        for (int i = 0; i < 1000; i++) {
+            file << "word" << i << " another  word\n";
+        }
+        file << "tail";
+    }
+
+    size_t savedThreshold = WcCommand::parallelThreshold();
+    std::istringstream input;
+    std::ostringstream error;
+
+    std::ostringstream streamed;
+    WcCommand(filename).execute(input, streamed, error);
+
+    WcCommand::setParallelThreshold(1);
+    std::ostringstream mapped;
+    int ret = WcCommand(filename).execute(input, mapped, error);
+    WcCommand::setParallelThreshold(savedThreshold);
+    std::remove(filename.c_str());
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(mapped.str(), streamed.str());
+    EXPECT_EQ(mapped.str(), "1000 3001 21894 " + filename + "\n");
+}
+
+#ifdef __linux__
+TEST(CommandsTest, WcProcFile) {
+    WcCommand cmd("/proc/self/status");
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    int ret = cmd.execute(input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_NE(output.str().rfind("0 0 0 ", 0), 0);
+}
+#endif
+
+#ifndef _WIN32
+TEST(CommandsTest, HashSeedsListsAndClears) {
+    CommandHashTable::getInstance().clear();
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    HashCommand seed({"sh"});
+    EXPECT_EQ(seed.execute(input, output, error), 0);
+
+    HashCommand list({});
+    list.execute(input, output, error);
+    EXPECT_EQ(output.str().rfind("hits\tcommand\n0\t", 0), 0);
+    EXPECT_NE(output.str().find("/sh\n"), std::string::npos);
+
+    HashCommand clear({"-r"});
+    EXPECT_EQ(clear.execute(input, output, error), 0);
+    EXPECT_TRUE(CommandHashTable::getInstance().entries().empty());
+}
+
+TEST(CommandsTest, HashUnknownCommand) {
+    HashCommand cmd({"no_such_program_xyz"});
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    EXPECT_EQ(cmd.execute(input, output, error), 1);
+    EXPECT_EQ(error.str(), "hash: no_such_program_xyz: not found\n");
+}
+
+TEST(CommandsTest, ParallelKeepsInputOrderWithK) {
+    ParallelCommand cmd({"-j", "4", "-k", "sh", "-c", "sleep 0.0$1; echo $1",
+                         "sh", "{}", ":::", "5", "3", "1", "4", "2"});
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    EXPECT_EQ(cmd.execute(input, output, error), 0);
+    EXPECT_EQ(output.str(), "5\n3\n1\n4\n2\n");
+}
+
+TEST(CommandsTest, ParallelReadsInputsAndCountsFailures) {
+    ParallelCommand cmd({"-j2", "sh", "-c"});
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input("exit 0\nexit 3\nexit 1\n");
+
+    EXPECT_EQ(cmd.execute(input, output, error), 2);
+    EXPECT_EQ(error.str(), "");
+}
+
+TEST(CommandsTest, ParallelRequiresCommand) {
+    ParallelCommand cmd({"-j", "2", ":::", "a"});
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    EXPECT_EQ(cmd.execute(input, output, error), 2);
+    EXPECT_EQ(error.str(), "parallel: missing command\n");
+}
+
+TEST(CommandsTest, ParallelRejectsInvalidJobCount) {
+    std::istringstream input;
+
+    for (const auto& args : std::vector<std::vector<std::string>>{
+             {"-j", "abc", "true"}, {"-j", "-3", "true"}, {"-j2x", "true"}}) {
+        ParallelCommand cmd(args);
+        std::ostringstream output;
+        std::ostringstream error;
+        EXPECT_EQ(cmd.execute(input, output, error), 2);
+        EXPECT_NE(error.str().find("invalid number of jobs"),
+                  std::string::npos);
+        EXPECT_EQ(output.str(), "");
+    }
+}
+#endif
+
+TEST(CommandsTest, SetTogglesPipefail) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    SetCommand enable({"-o", "pipefail"});
+    EXPECT_EQ(enable.execute(input, output, error), 0);
+    EXPECT_TRUE(env.pipefail());
+
+    SetCommand list({"-o"});
+    list.execute(input, output, error);
+    EXPECT_EQ(output.str(), "pipefail\ton\nshowplan\toff\n");
+
+    SetCommand disable({"+o", "pipefail"});
+    EXPECT_EQ(disable.execute(input, output, error), 0);
+    EXPECT_FALSE(env.pipefail());
+
+    SetCommand unknown({"-o", "no_such_option"});
+    EXPECT_EQ(unknown.execute(input, output, error), 1);
+    EXPECT_EQ(error.str(), "set: no_such_option: invalid option name\n");
+}
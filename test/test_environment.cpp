@@ -1,12 +1,19 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cstdlib>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include "command_executor.h"
+#include "command_hash_table.h"
 #include "commands/abstract_command.h"
 #include "environment_manager.h"
 #include "lexer.h"
 #include "parser.h"
+#include "variable_expander.h"
+#include "variable_table.h"
 
 TEST(EnvironmentTest, SetAndGetVariable) {
     EnvironmentManager& env = EnvironmentManager::getInstance();
@@ -53,7 +60,7 @@ TEST(EnvironmentTest, AssignmentViaParser) {
 TEST(EnvironmentTest, NonExistentVariable) {
     EnvironmentManager& env = EnvironmentManager::getInstance();
 
-    std::string value = env.getVariable("NON_EXISTENT_VAR_12345");
+    std::string value(env.getVariable("NON_EXISTENT_VAR_12345"));
     EXPECT_EQ(value, "");
 }
 
@@ -162,3 +169,218 @@ TEST(EnvironmentTest, ExitCodeInSingleQuotes) {
     EXPECT_EQ(ret, 0);
     EXPECT_EQ(output.str(), "$?\n");
 }
+
+#ifndef _WIN32
+TEST(EnvironmentTest, PathAssignmentClearsHashTable) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    CommandHashTable& table = CommandHashTable::getInstance();
+    std::string path(env.getVariable("PATH"));
+
+    ASSERT_TRUE(table.add("sh", path));
+    EXPECT_FALSE(table.entries().empty());
+
+    env.setVariable("PATH", path);
+    EXPECT_TRUE(table.entries().empty());
+}
+#endif
+
+TEST(VariableExpanderTest, ExpandsAllReferenceForms) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    env.setVariable("EXP_A", "alpha");
+    env.setVariable("?", "3");
+
+    EXPECT_EQ(VariableExpander::expand("$EXP_A ${EXP_A}x $?!", env),
+              "alpha alphax 3!");
+    EXPECT_EQ(VariableExpander::expand("[$EXP_UNSET]", env), "[]");
+}
+
+TEST(VariableExpanderTest, KeepsDollarWithoutReference) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+
+    EXPECT_EQ(VariableExpander::expand("$ $- ${} ${EXP_A $", env),
+              "$ $- ${} ${EXP_A $");
+}
+
+TEST(VariableExpanderTest, CompiledWordMatchesExpand) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    env.setVariable("EXP_B", std::string(100000, 'b'));
+    std::string text = "x${EXP_B}y$EXP_B$EXP_B";
+
+    Word word = VariableExpander::compile(text);
+
+    EXPECT_EQ(word.segments().size(), 5);
+    EXPECT_EQ(word.bind(env), VariableExpander::expand(text, env));
+    EXPECT_EQ(word.bind(env).size(), 300002);
+}
+
+TEST(EnvironmentTest, BracedVariableInArguments) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    env.setVariable("BRACED", "mid");
+
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto command =
+        parser.parse(lexer.tokenize("echo \"pre${BRACED}post\" ${BRACED}"));
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    executor.execute(command.get(), input, output, error);
+
+    EXPECT_EQ(output.str(), "premidpost mid\n");
+}
+
+TEST(EnvironmentTest, EnvpIsRebuiltOnlyAfterChange) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    env.setVariable("ENVP_VAR", "one");
+
+    auto contains = [](char* const* envp, const std::string& entry) {
+        for (; *envp; ++envp) {
+            if (entry == *envp) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    char* const* first = env.envp();
+    EXPECT_TRUE(contains(first, "ENVP_VAR=one"));
+
+    uint64_t version = env.version();
+    env.setVariable("?", "42");
+    EXPECT_EQ(env.version(), version);
+    EXPECT_EQ(env.envp(), first);
+    EXPECT_FALSE(contains(first, "?=42"));
+
+    env.setVariable("ENVP_VAR", "two");
+    EXPECT_NE(env.version(), version);
+    EXPECT_TRUE(contains(env.envp(), "ENVP_VAR=two"));
+    EXPECT_FALSE(contains(env.envp(), "ENVP_VAR=one"));
+}
+
+TEST(VariableTableTest, GrowsAndReplaces) {
+    VariableTable table;
+    for (int i = 0; i < 1000; i++) {
+        table.set("VAR_" + std::to_string(i), std::to_string(i));
+    }
+    table.set("VAR_7", "seven");
+
+    EXPECT_EQ(table.size(), 1000);
+    for (int i = 0; i < 1000; i++) {
+        const std::string* value = table.find("VAR_" + std::to_string(i));
+        ASSERT_NE(value, nullptr) << i;
+        EXPECT_EQ(*value, i == 7 ? "seven" : std::to_string(i));
+    }
+    EXPECT_EQ(table.find("VAR_1000"), nullptr);
+    EXPECT_EQ(table.find(""), nullptr);
+}
+
+TEST(VariableTableTest, CopiesShareUnchangedValues) {
+    VariableTable table;
+    for (int i = 0; i < 200; i++) {
+        table.set("VAR_" + std::to_string(i), std::string(1000, 'x'));
+    }
+    const std::string* shared = table.find("VAR_1");
+
+    VariableTable copy = table;
+    copy.set("VAR_2", "changed");
+    copy.set("NEW_VAR", "new");
+
+    EXPECT_EQ(copy.find("VAR_1"), shared);
+    EXPECT_EQ(*copy.find("VAR_2"), "changed");
+    EXPECT_EQ(*table.find("VAR_2"), std::string(1000, 'x'));
+    EXPECT_EQ(table.find("NEW_VAR"), nullptr);
+    EXPECT_EQ(table.size(), 200);
+    EXPECT_EQ(copy.size(), 201);
+}
+
+TEST(EnvironmentTest, ProcessEnvironmentIsImported) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    const char* home = std::getenv("HOME");
+    ASSERT_NE(home, nullptr);
+
+    EXPECT_TRUE(env.hasVariable("HOME"));
+    EXPECT_EQ(env.getVariable("HOME"), home);
+}
+
+TEST(EnvironmentTest, ExitCodeHasItsOwnSlot) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    uint64_t version = env.version();
+
+    env.setExitCode(7);
+    EXPECT_EQ(env.exitCode(), 7);
+    EXPECT_EQ(env.getVariable("?"), "7");
+    EXPECT_EQ(env.getAllVariables().count("?"), 0);
+    EXPECT_EQ(env.version(), version);
+}
+
+TEST(EnvironmentTest, ExitCodeViewsDoNotChange) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    auto snapshot = env.snapshot();
+
+    env.setExitCode(3);
+    std::string_view first = snapshot->get("?");
+    env.setExitCode(1000);
+    std::string_view second = snapshot->get("?");
+    env.setExitCode(0);
+    std::string_view third = snapshot->get("?");
+
+    EXPECT_EQ(first, "3");
+    EXPECT_EQ(second, "1000");
+    EXPECT_EQ(third, "0");
+}
+
+TEST(EnvironmentTest, SnapshotIsNotChangedByLaterAssignments) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    env.setVariable("SNAP_VAR", "before");
+
+    auto snapshot = env.snapshot();
+    std::string_view value = snapshot->get("SNAP_VAR");
+    env.setVariable("SNAP_VAR", "after");
+
+    EXPECT_EQ(value, "before");
+    EXPECT_EQ(snapshot->get("SNAP_VAR"), "before");
+    EXPECT_EQ(env.snapshot()->get("SNAP_VAR"), "after");
+    EXPECT_GT(env.snapshot()->version(), snapshot->version());
+}
+
+TEST(EnvironmentTest, ReadersNeverSeeTornValues) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    const std::string first(4096, 'a');
+    const std::string second(4096, 'b');
+    env.setVariable("TORN_VAR", first);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                auto snapshot = env.snapshot();
+                std::string_view value = snapshot->get("TORN_VAR");
+                std::string entry = "TORN_VAR=" + std::string(value);
+                bool inEnvp = false;
+                for (char* const* e = snapshot->envp(); *e; ++e) {
+                    inEnvp = inEnvp || entry == *e;
+                }
+                if ((value != first && value != second) || !inEnvp) {
+                    torn++;
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < 2000; i++) {
+        env.setVariable("TORN_VAR", i % 2 ? first : second);
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(torn.load(), 0);
+}
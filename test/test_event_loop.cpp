@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "event_loop.h"
+
+namespace {
+
+const EventLoop::Backend kBackends[] = {EventLoop::Backend::Epoll,
+                                        EventLoop::Backend::Poll};
+
+pid_t startChild(int exitCode) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        usleep(10000);
+        _exit(exitCode);
+    }
+    return pid;
+}
+
+}  // namespace
+
+TEST(EventLoopTest, DispatchesReadablePipes) {
+    for (auto backend : kBackends) {
+        EventLoop loop(backend);
+        int fds[2];
+        ASSERT_EQ(pipe(fds), 0);
+
+        std::string received;
+        loop.watch(fds[0], EventLoop::kReadable, [&](uint32_t) {
+            char buffer[16];
+            ssize_t n = read(fds[0], buffer, sizeof(buffer));
+            if (n > 0) {
+                received.append(buffer, n);
+            } else {
+                loop.unwatch(fds[0]);
+            }
+        });
+
+        ASSERT_EQ(write(fds[1], "ping", 4), 4);
+        close(fds[1]);
+        while (loop.runOnce(1000)) {
+        }
+
+        EXPECT_EQ(received, "ping");
+        EXPECT_TRUE(loop.empty());
+        close(fds[0]);
+    }
+}
+
+TEST(EventLoopTest, ReapsChildrenAsTheyExit) {
+    for (auto backend : kBackends) {
+        EventLoop loop(backend);
+        std::vector<int> exitCodes;
+        loop.watchChild(startChild(3), [&](int code) {
+            exitCodes.push_back(code);
+        });
+        loop.watchChild(startChild(0), [&](int code) {
+            exitCodes.push_back(code);
+        });
+
+        loop.run();
+
+        ASSERT_EQ(exitCodes.size(), 2);
+        EXPECT_EQ(exitCodes[0] + exitCodes[1], 3);
+    }
+}
+
+TEST(EventLoopTest, DeliversSignals) {
+    EventLoop loop;
+    int received = 0;
+    ASSERT_TRUE(loop.watchSignal(SIGUSR1, [&](int signo) {
+        received = signo;
+        loop.stop();
+    }));
+
+    raise(SIGUSR1);
+    loop.run();
+
+    EXPECT_EQ(received, SIGUSR1);
+}
+#endif
@@ -0,0 +1,310 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "fd_transfer.h"
+#include "mapped_file.h"
+#include "ring_buffer.h"
+#include "source_sink.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::string makeContent(size_t size) {
+    std::string content;
+    content.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        content += static_cast<char>('a' + i % 23);
+        if (i % 61 == 60) {
+            content += '\n';
+        }
+    }
+    return content;
+}
+
+void writeFile(const std::string& filename, const std::string& content) {
+    std::ofstream file(filename, std::ios::binary);
+    file << content;
+}
+
+std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+}  // namespace
+
+TEST(FdTransferTest, FileToFile) {
+    const std::string source = "fd_transfer_src.txt";
+    const std::string target = "fd_transfer_dst.txt";
+    std::string content = makeContent(300 * 1024);
+    writeFile(source, content);
+
+    int in = open(source.c_str(), O_RDONLY);
+    int out = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(in, 0);
+    ASSERT_GE(out, 0);
+
+    EXPECT_TRUE(FdTransfer::copy(in, out));
+    close(in);
+    close(out);
+
+    EXPECT_EQ(readFile(target), content);
+    std::remove(source.c_str());
+    std::remove(target.c_str());
+}
+
+TEST(FdTransferTest, FileToAppendedFile) {
+    const std::string source = "fd_transfer_src.txt";
+    const std::string target = "fd_transfer_dst.txt";
+    writeFile(source, "tail\n");
+    writeFile(target, "head\n");
+
+    int in = open(source.c_str(), O_RDONLY);
+    int out = open(target.c_str(), O_WRONLY | O_APPEND);
+    ASSERT_GE(in, 0);
+    ASSERT_GE(out, 0);
+
+    EXPECT_TRUE(FdTransfer::copy(in, out));
+    close(in);
+    close(out);
+
+    EXPECT_EQ(readFile(target), "head\ntail\n");
+    std::remove(source.c_str());
+    std::remove(target.c_str());
+}
+
+TEST(FdTransferTest, FileToPipe) {
+    const std::string source = "fd_transfer_src.txt";
+    std::string content = makeContent(16 * 1024);
+    writeFile(source, content);
+
+    int pipefd[2];
+    ASSERT_EQ(pipe(pipefd), 0);
+    int in = open(source.c_str(), O_RDONLY);
+    ASSERT_GE(in, 0);
+
+    // Fits into the default pipe buffer, so no reader thread is needed.
+    EXPECT_TRUE(FdTransfer::copy(in, pipefd[1]));
+    close(in);
+    close(pipefd[1]);
+
+    FdSource received(pipefd[0], true);
+    StringSink collected;
+    EXPECT_TRUE(FdTransfer::copy(received, collected));
+
+    EXPECT_EQ(collected.str(), content);
+    std::remove(source.c_str());
+}
+
+TEST(MappedFileTest, RegularFileIsMapped) {
+    const std::string filename = "mapped_file_test.txt";
+    std::string content = makeContent(MappedFile::kBlockSize + 1000);
+    writeFile(filename, content);
+
+    MappedFile file;
+    std::string errorMessage;
+    ASSERT_TRUE(file.open(filename, errorMessage));
+    EXPECT_TRUE(file.isMapped());
+    EXPECT_EQ(file.size(), content.size());
+
+    std::string collected;
+    const char* data;
+    size_t size;
+    while (file.next(data, size)) {
+        collected.append(data, size);
+    }
+
+    EXPECT_FALSE(file.failed());
+    EXPECT_EQ(collected, content);
+    std::remove(filename.c_str());
+}
+
+TEST(MappedFileTest, ShrinkingFileReportsError) {
+    const std::string filename = "mapped_file_shrink.txt";
+    writeFile(filename, makeContent(2 * MappedFile::kBlockSize));
+
+    MappedFile file;
+    std::string errorMessage;
+    ASSERT_TRUE(file.open(filename, errorMessage));
+    ASSERT_TRUE(file.isMapped());
+
+    const char* data;
+    size_t size;
+    ASSERT_TRUE(file.next(data, size));
+    ASSERT_EQ(truncate(filename.c_str(), 0), 0);
+
+    // The pages of the window handed out are gone: reading them must not
+    // raise SIGBUS.
+    size_t newlines = 0;
+    for (size_t i = 0; i < size; i++) {
+        newlines += data[i] == '\n';
+    }
+    EXPECT_LT(newlines, size);
+
+    EXPECT_FALSE(file.next(data, size));
+    EXPECT_TRUE(file.failed());
+    EXPECT_EQ(file.errorMessage(), "file truncated while reading");
+    std::remove(filename.c_str());
+}
+
+TEST(MappedFileTest, EmptyFileIsReadable) {
+    const std::string filename = "mapped_file_empty.txt";
+    writeFile(filename, "");
+
+    MappedFile file;
+    std::string errorMessage;
+    ASSERT_TRUE(file.open(filename, errorMessage));
+
+    const char* data;
+    size_t size;
+    EXPECT_FALSE(file.next(data, size));
+    EXPECT_FALSE(file.failed());
+    std::remove(filename.c_str());
+}
+
+TEST(MappedFileTest, FifoFallsBackToRead) {
+    const std::string filename = "mapped_file_fifo";
+    std::remove(filename.c_str());
+    ASSERT_EQ(mkfifo(filename.c_str(), 0600), 0);
+
+    // Opening a FIFO blocks until the other end appears, so a temporary
+    // non-blocking reader lets the writer open first.
+    MappedFile file;
+    std::string errorMessage;
+    int reader = open(filename.c_str(), O_RDONLY | O_NONBLOCK);
+    ASSERT_GE(reader, 0);
+    int writer = open(filename.c_str(), O_WRONLY);
+    ASSERT_GE(writer, 0);
+    ASSERT_TRUE(file.open(filename, errorMessage));
+    close(reader);
+
+    ASSERT_EQ(write(writer, "fifo data", 9), 9);
+    close(writer);
+
+    EXPECT_FALSE(file.isMapped());
+    std::string collected;
+    const char* data;
+    size_t size;
+    while (file.next(data, size)) {
+        collected.append(data, size);
+    }
+    EXPECT_EQ(collected, "fifo data");
+    std::remove(filename.c_str());
+}
+
+TEST(MappedFileTest, MissingFileReportsError) {
+    MappedFile file;
+    std::string errorMessage;
+    EXPECT_FALSE(file.open("missing_mapped_file_12345.txt", errorMessage));
+    EXPECT_FALSE(errorMessage.empty());
+}
+#endif
+
+TEST(FdTransferTest, StreamCopyIsByteExact) {
+    std::string content = "line\n\nno newline";
+    std::istringstream input(content);
+    std::ostringstream output;
+    StreamSource source(input);
+    StreamSink sink(output);
+
+    EXPECT_TRUE(FdTransfer::copy(source, sink));
+    EXPECT_EQ(output.str(), content);
+}
+
+TEST(FdTransferTest, StringStreamHasNoDescriptor) {
+    std::ostringstream output;
+    EXPECT_EQ(FdTransfer::streamDescriptor(output), -1);
+}
+
+TEST(SourceSinkTest, StreamAdaptersRoundTrip) {
+    StringSource source("alpha beta\ngamma");
+    SourceStreambuf inBuf(source);
+    std::istream in(&inBuf);
+
+    StringSink sink;
+    {
+        SinkStreambuf outBuf(sink);
+        std::ostream out(&outBuf);
+        std::string word;
+        while (in >> word) {
+            out << "[" << word << "]";
+        }
+    }
+
+    EXPECT_EQ(sink.str(), "[alpha][beta][gamma]");
+}
+
+TEST(SourceSinkTest, StreamSinkOnStdoutHasDescriptor) {
+    StreamSink sink(std::cout);
+#ifdef _WIN32
+    EXPECT_EQ(sink.fd(), -1);
+#else
+    EXPECT_EQ(sink.fd(), 1);
+#endif
+}
+
+TEST(SourceSinkTest, StdinStreamHasDescriptor) {
+    StringSource source("");
+    SourceStreambuf buffer(source);
+    std::istream wrapped(&buffer);
+    std::istringstream text("x");
+#ifdef _WIN32
+    EXPECT_EQ(FdTransfer::streamDescriptor(std::cin), -1);
+#else
+    EXPECT_EQ(FdTransfer::streamDescriptor(std::cin), 0);
+#endif
+    EXPECT_EQ(FdTransfer::streamDescriptor(wrapped), -1);
+    EXPECT_EQ(FdTransfer::streamDescriptor(text), -1);
+}
+
+TEST(RingBufferTest, TransfersMoreThanCapacity) {
+    RingBuffer ring(64);
+    std::string content;
+    for (int i = 0; i < 1000; i++) {
+        content += std::to_string(i) + ",";
+    }
+
+    std::thread writer([&] {
+        RingSink sink(ring);
+        for (size_t pos = 0; pos < content.size(); pos += 37) {
+            sink.write(content.substr(pos, 37));
+        }
+    });
+
+    RingSource source(ring);
+    StringSink collected;
+    EXPECT_TRUE(FdTransfer::copy(source, collected));
+    writer.join();
+
+    EXPECT_EQ(collected.str(), content);
+}
+
+TEST(RingBufferTest, ClosedReaderUnblocksWriter) {
+    RingBuffer ring(16);
+    std::thread reader([&] {
+        RingSource source(ring);
+        const char* data;
+        size_t size;
+        source.next(data, size);
+    });
+
+    RingSink sink(ring);
+    bool ok = true;
+    for (int i = 0; i < 100 && ok; i++) {
+        ok = sink.write("0123456789");
+    }
+    reader.join();
+
+    EXPECT_FALSE(ok);
+}
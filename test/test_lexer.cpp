@@ -71,6 +71,40 @@ TEST(LexerTest, MultiplePipes) {
     EXPECT_EQ(tokens[5].value, "wc");
 }
 
+TEST(LexerTest, AmpersandIsBackgroundOperator) {
+    Lexer lexer;
+    auto tokens = lexer.tokenize("sleep 5& echo '&'");
+
+    ASSERT_EQ(tokens.size(), 5);
+    EXPECT_EQ(tokens[1].value, "5");
+    EXPECT_EQ(tokens[2].value, "&");
+    EXPECT_EQ(tokens[2].type, TokenType::BACKGROUND);
+    EXPECT_EQ(tokens[4].value, "&");
+    EXPECT_EQ(tokens[4].type, TokenType::QUOTED_SINGLE);
+}
+
+TEST(LexerTest, RedirectionOperators) {
+    Lexer lexer;
+    auto tokens =
+        lexer.tokenize("cmd<in >out 2>>log 2>&1 a2>b '>' >>\"x y\"");
+
+    ASSERT_EQ(tokens.size(), 14);
+    EXPECT_EQ(tokens[1].value, "<");
+    EXPECT_EQ(tokens[1].type, TokenType::REDIRECT);
+    EXPECT_EQ(tokens[2].value, "in");
+    EXPECT_EQ(tokens[3].value, ">");
+    EXPECT_EQ(tokens[5].value, "2>>");
+    EXPECT_EQ(tokens[5].type, TokenType::REDIRECT);
+    EXPECT_EQ(tokens[7].value, "2>&1");
+    EXPECT_EQ(tokens[7].type, TokenType::REDIRECT);
+    // A digit inside a word is not a descriptor.
+    EXPECT_EQ(tokens[8].value, "a2");
+    EXPECT_EQ(tokens[9].value, ">");
+    EXPECT_EQ(tokens[11].type, TokenType::QUOTED_SINGLE);
+    EXPECT_EQ(tokens[12].value, ">>");
+    EXPECT_EQ(tokens[13].value, "x y");
+}
+
 TEST(LexerTest, PipeInQuotesNotOperator) {
     Lexer lexer;
     auto tokens = lexer.tokenize("echo 'hello | world'");
@@ -101,3 +135,49 @@ TEST(LexerTest, PipeWithoutSpaces) {
     EXPECT_EQ(tokens[1].type, TokenType::PIPE);
     EXPECT_EQ(tokens[2].value, "wc");
 }
+
+TEST(LexerTest, ViewsPointIntoInput) {
+    Lexer lexer;
+    std::string line = "echo 'a b' \"c|d\" X=1|wc";
+    auto views = lexer.tokenizeView(line);
+
+    ASSERT_EQ(views.size(), 6);
+    EXPECT_EQ(views[1].value, "a b");
+    EXPECT_EQ(views[1].type, TokenType::QUOTED_SINGLE);
+    EXPECT_EQ(views[2].value, "c|d");
+    EXPECT_EQ(views[2].type, TokenType::QUOTED_DOUBLE);
+    EXPECT_EQ(views[3].type, TokenType::ASSIGNMENT);
+    EXPECT_EQ(views[4].type, TokenType::PIPE);
+    for (const auto& view : views) {
+        EXPECT_GE(view.value.data(), line.data());
+        EXPECT_LE(view.value.data() + view.value.size(),
+                  line.data() + line.size());
+    }
+}
+
+TEST(LexerTest, ViewsMatchOwningTokens) {
+    Lexer lexer;
+    std::string line = "cat file | wc  'unterminated";
+    auto tokens = lexer.tokenize(line);
+    auto views = lexer.tokenizeView(line);
+
+    ASSERT_EQ(tokens.size(), views.size());
+    for (size_t i = 0; i < tokens.size(); i++) {
+        EXPECT_EQ(tokens[i].type, views[i].type);
+        EXPECT_EQ(tokens[i].value, views[i].str());
+    }
+    EXPECT_EQ(views.back().value, "unterminated");
+}
+
+TEST(LexerTest, ReusedVectorKeepsStorage) {
+    Lexer lexer;
+    std::vector<TokenView> views;
+    lexer.tokenizeView("a b c d e f", views);
+    const TokenView* storage = views.data();
+
+    lexer.tokenizeView("x | y", views);
+
+    ASSERT_EQ(views.size(), 3);
+    EXPECT_EQ(views.data(), storage);
+    EXPECT_EQ(views[2].value, "y");
+}
@@ -1,9 +1,19 @@
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "command_factory.h"
 #include "commands/abstract_command.h"
+#include "commands/echo_command.h"
 #include "environment_manager.h"
 #include "lexer.h"
+#include "parse_cache.h"
 #include "parser.h"
+#include "pipeline_optimizer.h"
+#include "ring_buffer.h"
 
 TEST(ParserTest, SimpleCommand) {
     EnvironmentManager& env = EnvironmentManager::getInstance();
@@ -40,3 +50,330 @@ TEST(ParserTest, VariableSubstitution) {
 
     ASSERT_NE(command, nullptr);
 }
+
+TEST(ParserTest, ParseLineCachesRepeatedLines) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+
+    ASSERT_NE(parser.parseLine("echo a | wc"), nullptr);
+    ASSERT_NE(parser.parseLine("echo a | wc"), nullptr);
+    ASSERT_NE(parser.parseLine("echo b"), nullptr);
+
+    EXPECT_EQ(parser.cache().hits(), 1);
+    EXPECT_EQ(parser.cache().misses(), 2);
+    EXPECT_EQ(parser.cache().size(), 2);
+}
+
+TEST(ParserTest, CachedLineSeesCurrentVariables) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+
+    auto run = [&](const std::string& line) {
+        auto command = parser.parseLine(line);
+        std::ostringstream output;
+        std::ostringstream error;
+        std::istringstream input;
+        if (command) {
+            command->execute(input, output, error);
+        }
+        return output.str();
+    };
+
+    run("CACHED_VAR=first");
+    EXPECT_EQ(run("echo \"$CACHED_VAR\" $CACHED_VAR"), "first first\n");
+    run("CACHED_VAR=second");
+    EXPECT_EQ(run("echo \"$CACHED_VAR\" $CACHED_VAR"), "second second\n");
+    EXPECT_EQ(parser.cache().hits(), 1);
+}
+
+TEST(ParserTest, SyntaxErrorsAreNotCached) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+
+    EXPECT_EQ(parser.parseLine("echo a |"), nullptr);
+    EXPECT_EQ(parser.parseLine("   "), nullptr);
+    EXPECT_EQ(parser.cache().size(), 0);
+}
+
+TEST(ParseCacheTest, EvictsLeastRecentlyUsed) {
+    ParseCache cache(2);
+    auto plan = CommandPlan::pipeline({});
+
+    cache.insert("a", plan);
+    cache.insert("b", plan);
+    EXPECT_NE(cache.find("a"), nullptr);
+    cache.insert("c", plan);
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_NE(cache.find("a"), nullptr);
+    EXPECT_EQ(cache.find("b"), nullptr);
+    EXPECT_NE(cache.find("c"), nullptr);
+}
+
+TEST(ParserTest, CompileSplitsWordsIntoSegments) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+
+    auto plan = parser.compile(
+        lexer.tokenizeView("echo \"a $X-$? $\" 'lit $Y' | tool $Z"));
+
+    ASSERT_NE(plan, nullptr);
+    ASSERT_EQ(plan->stages().size(), 2);
+    EXPECT_EQ(plan->stages()[0].builtin, parser.factory().findBuiltin("echo"));
+    EXPECT_EQ(plan->stages()[1].builtin, kNoBuiltin);
+
+    const auto& quoted = plan->stages()[0].words[1].segments();
+    ASSERT_EQ(quoted.size(), 5);
+    EXPECT_EQ(quoted[0].text, "a ");
+    EXPECT_EQ(quoted[1].kind, WordSegment::Kind::Variable);
+    EXPECT_EQ(quoted[1].text, "X");
+    EXPECT_EQ(quoted[2].text, "-");
+    EXPECT_EQ(quoted[3].text, "?");
+    EXPECT_EQ(quoted[4].text, " $");
+
+    EXPECT_TRUE(plan->stages()[0].words[2].isLiteral());
+    EXPECT_FALSE(plan->stages()[1].words[1].isLiteral());
+}
+
+TEST(ParserTest, TrailingAmpersandMakesBackgroundPlan) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+
+    auto plan = parser.compile(lexer.tokenizeView("echo 'a b' | wc &"));
+    ASSERT_NE(plan, nullptr);
+    EXPECT_TRUE(plan->isBackground());
+    EXPECT_EQ(plan->stages().size(), 2);
+
+    EXPECT_FALSE(
+        parser.compile(lexer.tokenizeView("echo a | wc"))->isBackground());
+    EXPECT_EQ(parser.compile(lexer.tokenizeView("echo a & | wc")), nullptr);
+}
+
+TEST(ParserTest, RedirectionsAreKeptOutOfWords) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+
+    auto plan = parser.compile(
+        lexer.tokenizeView("< in wc -l > \"$OUT\" 2>&1 | cat 2>> log"));
+    ASSERT_NE(plan, nullptr);
+    ASSERT_EQ(plan->stages().size(), 2);
+
+    const StagePlan& first = plan->stages()[0];
+    ASSERT_EQ(first.words.size(), 2);
+    EXPECT_NE(first.builtin, kNoBuiltin);
+    ASSERT_EQ(first.redirects.size(), 3);
+    EXPECT_EQ(first.redirects[0].kind, Redirection::Kind::Input);
+    EXPECT_EQ(first.redirects[0].fd, 0);
+    EXPECT_EQ(first.redirects[1].kind, Redirection::Kind::Output);
+    EXPECT_FALSE(first.redirects[1].target.isLiteral());
+    EXPECT_EQ(first.redirects[2].kind, Redirection::Kind::Duplicate);
+    EXPECT_EQ(first.redirects[2].fd, 2);
+    EXPECT_EQ(first.redirects[2].targetFd, 1);
+
+    const StagePlan& second = plan->stages()[1];
+    ASSERT_EQ(second.redirects.size(), 1);
+    EXPECT_EQ(second.redirects[0].kind, Redirection::Kind::Append);
+    EXPECT_EQ(second.redirects[0].fd, 2);
+
+    EXPECT_EQ(parser.compile(lexer.tokenizeView("echo >")), nullptr);
+    EXPECT_EQ(parser.compile(lexer.tokenizeView("echo > | cat")), nullptr);
+    EXPECT_EQ(parser.compile(lexer.tokenizeView("> file")), nullptr);
+    EXPECT_EQ(parser.compile(lexer.tokenizeView("echo 2< file")), nullptr);
+    EXPECT_EQ(parser.compile(lexer.tokenizeView("echo 2>&0")), nullptr);
+}
+
+TEST(ParserTest, PlanBindsCurrentEnvironment) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+
+    auto plan = parser.compile(lexer.tokenizeView("$PLAN_CMD \"<$PLAN_ARG>\""));
+    ASSERT_NE(plan, nullptr);
+
+    auto run = [&] {
+        auto command = plan->bind(env, parser.factory());
+        std::ostringstream output;
+        std::ostringstream error;
+        std::istringstream input;
+        command->execute(input, output, error);
+        return output.str();
+    };
+
+    env.setVariable("PLAN_CMD", "echo");
+    env.setVariable("PLAN_ARG", "one");
+    EXPECT_EQ(run(), "<one>\n");
+
+    env.setVariable("PLAN_ARG", "two");
+    EXPECT_EQ(run(), "<two>\n");
+}
+
+TEST(CommandFactoryTest, FindsStandardBuiltins) {
+    CommandFactory factory;
+
+    for (const char* name : {"cat", "echo", "exit", "hash", "pwd", "wc"}) {
+        EXPECT_NE(factory.findBuiltin(name), kNoBuiltin) << name;
+    }
+    EXPECT_EQ(factory.findBuiltin("ls"), kNoBuiltin);
+    EXPECT_EQ(factory.findBuiltin(""), kNoBuiltin);
+    EXPECT_EQ(factory.findBuiltin("echoo"), kNoBuiltin);
+}
+
+TEST(ParserTest, RegisteredBuiltinReplacesCachedExternal) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+
+    auto compiled = parser.compile(Lexer().tokenizeView("greet"));
+    ASSERT_NE(compiled, nullptr);
+    EXPECT_EQ(compiled->stages()[0].builtin, kNoBuiltin);
+    parser.parseLine("greet");
+
+    BuiltinId id = parser.registerBuiltin(
+        "greet", [](const std::vector<std::string>& args)
+                     -> std::unique_ptr<AbstractCommand> {
+            return std::make_unique<EchoCommand>(
+                std::vector<std::string>{"hi"});
+        });
+    EXPECT_EQ(parser.factory().findBuiltin("greet"), id);
+
+    auto command = parser.parseLine("greet");
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+    command->execute(input, output, error);
+
+    EXPECT_EQ(output.str(), "hi\n");
+}
+
+namespace {
+
+// Plan PipelineOptimizer makes of line when it is bound now.
+std::string optimized(Parser& parser, const std::string& line) {
+    auto plan = parser.compile(Lexer().tokenizeView(line));
+    if (!plan) {
+        return "<none>";
+    }
+    std::vector<StagePlan> stages = plan->stages();
+    auto folded = PipelineOptimizer(parser.factory())
+                      .optimize(stages,
+                                *EnvironmentManager::getInstance().snapshot(),
+                                plan->isBackground());
+    return plan->rewritten(std::move(stages), std::move(folded))->describe();
+}
+
+void writeFile(const std::string& path, size_t size) {
+    std::ofstream file(path);
+    file << std::string(size, 'x');
+}
+
+}  // namespace
+
+TEST(ParserTest, OptimizerFoldsCatAndEcho) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    writeFile("optimizer_small.txt", 10);
+    env.setVariable("OPTIMIZER_FILE", "optimizer_small.txt");
+
+    EXPECT_EQ(optimized(parser, "cat optimizer_small.txt | wc -l"),
+              "wc -l < optimizer_small.txt");
+    EXPECT_EQ(optimized(parser, "cat $OPTIMIZER_FILE | wc"),
+              "wc < optimizer_small.txt");
+    EXPECT_EQ(optimized(parser, "cat < optimizer_small.txt | wc > out"),
+              "wc < optimizer_small.txt > out");
+    EXPECT_EQ(optimized(parser, "echo a 'b c' $X | tr a-z A-Z"),
+              "tr a-z A-Z <<< \"a b c ${X}\"");
+    EXPECT_EQ(optimized(parser, "echo hi | cat | wc"), "cat <<< hi | wc");
+
+    // Nothing to fold: no successor, stdin read on purpose, or arguments
+    // cat would treat differently from a redirection.
+    EXPECT_EQ(optimized(parser, "cat optimizer_small.txt"),
+              "cat optimizer_small.txt");
+    EXPECT_EQ(optimized(parser, "cat | wc"), "cat | wc");
+    EXPECT_EQ(optimized(parser, "cat - | wc"), "cat - | wc");
+    EXPECT_EQ(optimized(parser, "cat a b | wc"), "cat a b | wc");
+    EXPECT_EQ(optimized(parser, "echo hi 2> log | wc"), "echo hi 2> log | wc");
+
+    std::remove("optimizer_small.txt");
+}
+
+TEST(ParserTest, OptimizerKeepsObservableStages) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    writeFile("optimizer_small.txt", 10);
+    writeFile("optimizer_big.txt", 2 * RingBuffer::kDefaultCapacity);
+
+    // cat reports files it cannot read itself.
+    EXPECT_EQ(optimized(parser, "cat no_such_file.txt | wc"),
+              "cat no_such_file.txt | wc");
+    EXPECT_EQ(optimized(parser, "cat . | wc"), "cat . | wc");
+
+    // The receiver reads its own input, not the pipe.
+    EXPECT_EQ(optimized(parser, "cat optimizer_small.txt | wc < in"),
+              "cat optimizer_small.txt | wc < in");
+    EXPECT_EQ(optimized(parser, "echo hi | wc < in"), "echo hi | wc < in");
+
+    // Stages that may fail only fold where no status is recorded.
+    EXPECT_EQ(optimized(parser, "cat optimizer_big.txt | wc"),
+              "cat optimizer_big.txt | wc");
+    EXPECT_EQ(optimized(parser, "cat optimizer_big.txt | wc &"),
+              "wc < optimizer_big.txt &");
+    EXPECT_EQ(optimized(parser, "ls | cat | cat | wc"), "ls | cat | cat | wc");
+    EXPECT_EQ(optimized(parser, "ls | cat | cat | wc &"), "ls | wc &");
+    EXPECT_EQ(optimized(parser, "echo hi | cat | wc &"), "wc <<< hi &");
+
+    std::remove("optimizer_small.txt");
+    std::remove("optimizer_big.txt");
+}
+
+TEST(ParserTest, OptimizerKeepsStateChangingStagesInPipeline) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+
+    // Alone, `exit` would run in the interpreter and end it.
+    EXPECT_EQ(optimized(parser, "echo 1 | exit"), "echo 1 | exit");
+    EXPECT_EQ(optimized(parser, "echo 1 | cat | exit"), "cat <<< 1 | exit");
+}
+
+TEST(ParserTest, OptimizerLeavesReplacedBuiltinsAlone) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    writeFile("optimizer_small.txt", 10);
+
+    parser.registerBuiltin(
+        "cat", [](const std::vector<std::string>& args)
+                   -> std::unique_ptr<AbstractCommand> {
+            return std::make_unique<EchoCommand>(args);
+        });
+
+    EXPECT_EQ(optimized(parser, "cat optimizer_small.txt | wc"),
+              "cat optimizer_small.txt | wc");
+
+    std::remove("optimizer_small.txt");
+}
+
+TEST(ParserTest, ShowPlanPrintsOptimizedPlan) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+
+    std::stringstream captured_cerr;
+    std::streambuf* old_cerr = std::cerr.rdbuf(captured_cerr.rdbuf());
+    parser.parseLine("echo quiet | wc");
+    env.setShowPlan(true);
+    parser.parseLine("echo shown | wc");
+    env.setPipefail(true);
+    parser.parseLine("echo shown | wc");
+    env.setPipefail(false);
+    parser.setOptimize(false);
+    parser.parseLine("echo shown | wc");
+    env.setShowPlan(false);
+    std::cerr.rdbuf(old_cerr);
+
+    EXPECT_EQ(captured_cerr.str(),
+              "plan: wc <<< shown\n"
+              "plan: echo shown | wc\n"
+              "plan: echo shown | wc\n");
+}
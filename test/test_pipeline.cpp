@@ -1,13 +1,25 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "command_executor.h"
+#include "command_hash_table.h"
 #include "commands/abstract_command.h"
+#include "commands/exit_command.h"
 #include "environment_manager.h"
+#include "job_table.h"
 #include "lexer.h"
 #include "parser.h"
+#include "source_sink.h"
 
 TEST(PipelineTest, ParserDetectsPipeline) {
     EnvironmentManager& env = EnvironmentManager::getInstance();
@@ -193,3 +205,457 @@ TEST(PipelineTest, ExitCodeOfLastCommand) {
 
     EXPECT_EQ(ret, 0);
 }
+
+TEST(PipelineTest, BuiltinStagesWriteToCallerStream) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto tokens = lexer.tokenize("echo hello world | cat | cat | wc");
+    auto command = parser.parse(tokens);
+
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    int ret = executor.execute(command.get(), input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "1 2 12\n");
+}
+
+TEST(PipelineTest, BuiltinReadsCallerInput) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto tokens = lexer.tokenize("cat | wc");
+    auto command = parser.parse(tokens);
+
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input("one two\nthree\n");
+
+    int ret = executor.execute(command.get(), input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "2 3 14\n");
+}
+
+#ifndef _WIN32
+TEST(PipelineTest, ExternalStageBetweenBuiltins) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto tokens = lexer.tokenize("echo hello | tr a-z A-Z | cat");
+    auto command = parser.parse(tokens);
+
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    int ret = executor.execute(command.get(), input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "HELLO\n");
+}
+
+TEST(PipelineTest, LargeStreamThroughRingBuffers) {
+    const std::string filename = "pipeline_large_input.txt";
+    std::string content;
+    for (int i = 0; i < 20000; i++) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << content;
+    }
+
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto tokens = lexer.tokenize("cat " + filename + " | cat | cat");
+    auto command = parser.parse(tokens);
+
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    int ret = executor.execute(command.get(), input, output, error);
+    std::remove(filename.c_str());
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), content);
+}
+
+TEST(PipelineTest, MissingProgramFailsOnlyItsStage) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto tokens = lexer.tokenize("echo hi | no_such_program_xyz | wc");
+    auto command = parser.parse(tokens);
+
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    int ret = executor.execute(command.get(), input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "0 0 0\n");
+    EXPECT_NE(error.str().find("Failed to execute: no_such_program_xyz"),
+              std::string::npos);
+}
+
+TEST(PipelineTest, ExternalCommandUsesCallerStreams) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    CommandExecutor executor;
+
+    auto command = parser.parseLine("sh -c 'tr a-z A-Z; echo oops >&2'");
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input("from caller\n");
+
+    int ret = executor.execute(command.get(), input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "FROM CALLER\n");
+    EXPECT_EQ(error.str(), "oops\n");
+}
+
+TEST(PipelineTest, ScriptWithoutShebangRunsThroughShell) {
+    const std::string script = "./pipeline_no_shebang.sh";
+    {
+        std::ofstream file(script);
+        file << "echo \"script $1\"\n";
+    }
+    chmod(script.c_str(), 0755);
+
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    CommandExecutor executor;
+    std::istringstream input;
+
+    for (const std::string& line :
+         {script + " alone", script + " piped | tr a-z A-Z"}) {
+        auto command = parser.parseLine(line);
+        ASSERT_NE(command, nullptr);
+
+        std::ostringstream output;
+        std::ostringstream error;
+        EXPECT_EQ(executor.execute(command.get(), input, output, error), 0);
+        EXPECT_EQ(error.str(), "");
+        EXPECT_EQ(output.str(), line.find('|') == std::string::npos
+                                    ? "script alone\n"
+                                    : "SCRIPT PIPED\n");
+    }
+
+    std::remove(script.c_str());
+}
+
+TEST(PipelineTest, ExternalCommandPumpsLargeStreams) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    CommandExecutor executor;
+
+    // Far more than a pipe holds in either direction: input and output
+    // must be pumped together.
+    std::string content;
+    for (int i = 0; i < 200000; i++) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input(content);
+
+    auto external = parser.parseLine("/bin/cat");
+    ASSERT_NE(external, nullptr);
+
+    EXPECT_EQ(executor.execute(external.get(), input, output, error), 0);
+    EXPECT_EQ(output.str(), content);
+
+    // A program exiting without reading its input must not take the
+    // interpreter down with SIGPIPE.
+    std::istringstream unread(content);
+    auto ignoring = parser.parseLine("true");
+    EXPECT_EQ(executor.execute(ignoring.get(), unread, output, error), 0);
+}
+
+TEST(PipelineTest, PipelineEndsUseCallerStreams) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    CommandExecutor executor;
+
+    auto command = parser.parseLine("/bin/cat | sh -c 'tr a-z A-Z >&2'");
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input("abc\n");
+
+    int ret = executor.execute(command.get(), input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "");
+    EXPECT_EQ(error.str(), "ABC\n");
+}
+
+TEST(PipelineTest, StaleHashedPathIsSearchedAgain) {
+    const std::string first = "hash_first_dir";
+    const std::string second = "hash_second_dir";
+    mkdir(first.c_str(), 0755);
+    mkdir(second.c_str(), 0755);
+    auto writeScript = [](const std::string& path, const std::string& text) {
+        std::ofstream script(path);
+        script << "#!/bin/sh\necho " << text << "\n";
+        script.close();
+        chmod(path.c_str(), 0755);
+    };
+    writeScript(first + "/hashprobe", "first");
+
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    std::string savedPath(env.getVariable("PATH"));
+    env.setVariable("PATH", first + ":" + second + ":" + savedPath);
+
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+    auto run = [&] {
+        auto command = parser.parse(lexer.tokenize("hashprobe | cat"));
+        std::ostringstream output;
+        std::ostringstream error;
+        std::istringstream input;
+        executor.execute(command.get(), input, output, error);
+        return output.str();
+    };
+
+    EXPECT_EQ(run(), "first\n");
+    EXPECT_EQ(CommandHashTable::getInstance().find("hashprobe", ""),
+              first + "/hashprobe");
+
+    // Move the program; the remembered path now fails to exec.
+    unlink((first + "/hashprobe").c_str());
+    writeScript(second + "/hashprobe", "second");
+    EXPECT_EQ(run(), "second\n");
+
+    env.setVariable("PATH", savedPath);
+    unlink((second + "/hashprobe").c_str());
+    rmdir(first.c_str());
+    rmdir(second.c_str());
+}
+
+TEST(PipelineTest, SpawnedStageSeesShellVariables) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    env.setVariable("PIPELINE_SPAWN_VAR", "visible");
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto tokens = lexer.tokenize("printenv PIPELINE_SPAWN_VAR | cat");
+    auto command = parser.parse(tokens);
+
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    int ret = executor.execute(command.get(), input, output, error);
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(output.str(), "visible\n");
+}
+
+TEST(PipelineTest, PipestatusListsEveryStage) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto command = parser.parse(lexer.tokenize("false | echo hi | true"));
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    EXPECT_EQ(executor.execute(command.get(), input, output, error), 0);
+    EXPECT_EQ(env.getVariable("PIPESTATUS"), "1 0 0");
+}
+
+TEST(PipelineTest, PipestatusListsFoldedStages) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    CommandExecutor executor;
+
+    auto run = [&](const std::string& line) {
+        auto command = parser.parseLine(line);
+        std::ostringstream output;
+        std::ostringstream error;
+        std::istringstream input;
+        executor.execute(command.get(), input, output, error);
+        return output.str();
+    };
+
+    // `echo` is folded into `wc` but still has its status.
+    EXPECT_EQ(run("echo hi | wc"), "1 1 3\n");
+    EXPECT_EQ(env.getVariable("PIPESTATUS"), "0 0");
+
+    EXPECT_EQ(run("echo hi | cat | false"), "");
+    EXPECT_EQ(env.getVariable("PIPESTATUS"), "0 0 1");
+}
+
+TEST(PipelineTest, PipestatusFollowsEveryCommandAndIsNotExported) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    CommandExecutor executor;
+    std::istringstream input;
+
+    auto run = [&](const std::string& line) {
+        auto command = parser.parseLine(line);
+        std::ostringstream output;
+        std::ostringstream error;
+        executor.execute(command.get(), input, output, error);
+        return output.str();
+    };
+
+    run("false | true");
+    EXPECT_EQ(env.getVariable("PIPESTATUS"), "1 0");
+    run("false");
+    EXPECT_EQ(env.getVariable("PIPESTATUS"), "1");
+
+    run("true");
+    EXPECT_EQ(env.getVariable("PIPESTATUS"), "0");
+    EXPECT_EQ(run("sh -c 'env' | grep -c ^PIPESTATUS="), "0\n");
+    EXPECT_EQ(env.getAllVariables().count("PIPESTATUS"), 0);
+}
+
+TEST(PipelineTest, PipefailTearsDownRemainingStages) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto command = parser.parse(lexer.tokenize("sleep 30 | false | cat"));
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    env.setPipefail(true);
+    auto start = std::chrono::steady_clock::now();
+    int ret = executor.execute(command.get(), input, output, error);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    env.setPipefail(false);
+
+    EXPECT_EQ(ret, 1);
+    EXPECT_LT(elapsed, std::chrono::seconds(10));
+    EXPECT_EQ(env.getVariable("PIPESTATUS"), "143 1 0");
+}
+
+TEST(PipelineTest, BuiltinStageErrorsAppearRightAway) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+
+    // Remembers how long after start the first error arrived.
+    struct TimedSink : StringSink {
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration firstWrite{};
+
+        bool write(const char* data, size_t size) override {
+            if (str().empty()) {
+                firstWrite = std::chrono::steady_clock::now() - start;
+            }
+            return StringSink::write(data, size);
+        }
+        using StringSink::write;
+    };
+
+    auto command = parser.parseLine("cat no_such_file.txt | sleep 2");
+    ASSERT_NE(command, nullptr);
+    StringSource input("");
+    StringSink output;
+    TimedSink error;
+    command->execute(input, output, error);
+
+    EXPECT_EQ(error.str(),
+              "cat: no_such_file.txt: No such file or directory\n");
+    EXPECT_LT(error.firstWrite, std::chrono::seconds(1));
+}
+
+TEST(PipelineTest, BackgroundJobsRunWhileInterpreterContinues) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    CommandExecutor executor;
+    JobTable& jobs = JobTable::getInstance();
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+    auto run = [&](const std::string& line) {
+        auto command = parser.parseLine(line);
+        return executor.execute(command.get(), input, output, error);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(run("sleep 30 &"), 0);
+    EXPECT_EQ(run("echo x | sh -c 'exit 4' &"), 0);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::seconds(10));
+
+    int sleeper = jobs.current() - 1;
+    EXPECT_EQ(run("jobs"), 0);
+    EXPECT_NE(output.str().find("Running\tsleep 30 &"), std::string::npos);
+
+    EXPECT_EQ(run("wait %" + std::to_string(jobs.current())), 4);
+
+    kill(jobs.jobs()[0].pid, SIGTERM);
+    EXPECT_EQ(jobs.wait(sleeper), 128 + SIGTERM);
+    EXPECT_TRUE(jobs.jobs().empty());
+    EXPECT_EQ(run("wait %1"), 127);
+}
+#endif
+
+TEST(PipelineTest, ExitInPipelineDoesNotStopInterpreter) {
+    EnvironmentManager& env = EnvironmentManager::getInstance();
+    Parser parser(env);
+    Lexer lexer;
+    CommandExecutor executor;
+
+    auto tokens = lexer.tokenize("echo bye | exit");
+    auto command = parser.parse(tokens);
+
+    ASSERT_NE(command, nullptr);
+
+    std::ostringstream output;
+    std::ostringstream error;
+    std::istringstream input;
+
+    executor.execute(command.get(), input, output, error);
+
+    EXPECT_FALSE(ExitCommand::shouldExit());
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "command_executor.h"
+#include "commands/abstract_command.h"
+#include "environment_manager.h"
+#include "parser.h"
+
+namespace {
+
+std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// Runs one line with string streams and returns its exit code.
+int run(const std::string& line, std::string& output, std::string& error,
+        const std::string& input = "") {
+    Parser parser(EnvironmentManager::getInstance());
+    CommandExecutor executor;
+    auto command = parser.parseLine(line);
+    if (!command) {
+        return -1;
+    }
+
+    std::istringstream in(input);
+    std::ostringstream out;
+    std::ostringstream err;
+    int ret = executor.execute(command.get(), in, out, err);
+    output = out.str();
+    error = err.str();
+    return ret;
+}
+
+}  // namespace
+
+TEST(RedirectionTest, BuiltinOutputGoesToFile) {
+    const std::string filename = "redirect_builtin.txt";
+    std::string output;
+    std::string error;
+
+    EXPECT_EQ(run("echo first > " + filename, output, error), 0);
+    EXPECT_EQ(run("echo second >> " + filename, output, error), 0);
+    EXPECT_EQ(output, "");
+    EXPECT_EQ(readFile(filename), "first\nsecond\n");
+
+    EXPECT_EQ(run("echo third > " + filename, output, error), 0);
+    EXPECT_EQ(readFile(filename), "third\n");
+
+    std::remove(filename.c_str());
+}
+
+TEST(RedirectionTest, InputComesFromFile) {
+    const std::string filename = "redirect_input.txt";
+    {
+        std::ofstream file(filename);
+        file << "one two\nthree\n";
+    }
+    std::string output;
+    std::string error;
+
+    EXPECT_EQ(run("wc < " + filename, output, error, "ignored\n"), 0);
+    EXPECT_EQ(output, "2 3 14\n");
+
+    std::remove(filename.c_str());
+}
+
+TEST(RedirectionTest, MissingFileFailsCommand) {
+    std::string output;
+    std::string error;
+
+    EXPECT_EQ(run("echo never > no_such_dir/file", output, error), 1);
+    EXPECT_EQ(output, "");
+    EXPECT_EQ(error, "no_such_dir/file: No such file or directory\n");
+
+    EXPECT_EQ(run("wc < no_such_file.txt", output, error), 1);
+    EXPECT_NE(error.find("no_such_file.txt"), std::string::npos);
+}
+
+#ifndef _WIN32
+TEST(RedirectionTest, DuplicationFollowsCommandLineOrder) {
+    const std::string filename = "redirect_order.txt";
+    const std::string program = "sh -c 'echo out; echo err >&2'";
+    std::string output;
+    std::string error;
+
+    EXPECT_EQ(run(program + " > " + filename + " 2>&1", output, error), 0);
+    EXPECT_EQ(output, "");
+    EXPECT_EQ(error, "");
+    EXPECT_EQ(readFile(filename), "out\nerr\n");
+
+    EXPECT_EQ(run(program + " 2>&1 > " + filename, output, error), 0);
+    EXPECT_EQ(output, "err\n");
+    EXPECT_EQ(error, "");
+    EXPECT_EQ(readFile(filename), "out\n");
+
+    EXPECT_EQ(run(program + " 2> " + filename, output, error), 0);
+    EXPECT_EQ(output, "out\n");
+    EXPECT_EQ(readFile(filename), "err\n");
+
+    std::remove(filename.c_str());
+}
+
+TEST(RedirectionTest, PipelineStagesUseTheirFiles) {
+    const std::string input = "redirect_stage_in.txt";
+    const std::string result = "redirect_stage_out.txt";
+    {
+        std::ofstream file(input);
+        file << "abc\n";
+    }
+    std::string output;
+    std::string error;
+
+    // Stage ends are redirected at the descriptor level: the external
+    // stages read and write the files themselves.
+    EXPECT_EQ(run("tr a-z A-Z < " + input + " | cat | tr A-Z x-z > " +
+                      result,
+                  output, error),
+              0);
+    EXPECT_EQ(output, "");
+    EXPECT_EQ(readFile(result), "xyz\n");
+
+    EXPECT_EQ(run("cat < " + input + " | wc > " + result, output, error), 0);
+    EXPECT_EQ(readFile(result), "1 1 4\n");
+
+    std::remove(input.c_str());
+    std::remove(result.c_str());
+}
+#endif
+
+TEST(RedirectionTest, OptimizedPipelinesKeepTheirOutput) {
+    const std::string filename = "redirect_optimized.txt";
+    {
+        std::ofstream file(filename);
+        file << "one two\nthree\n";
+    }
+    std::string output;
+    std::string error;
+
+    EXPECT_EQ(run("cat " + filename + " | wc", output, error), 0);
+    EXPECT_EQ(output, "2 3 14\n");
+
+    EXPECT_EQ(run("echo a  b | cat | wc", output, error, "ignored\n"), 0);
+    EXPECT_EQ(output, "1 2 4\n");
+
+    EXPECT_EQ(run("cat | cat | wc", output, error, "x\n"), 0);
+    EXPECT_EQ(output, "1 1 2\n");
+
+    // A file cat cannot read is left for cat to report.
+    EXPECT_EQ(run("cat no_such_file.txt | wc", output, error), 0);
+    EXPECT_EQ(output, "0 0 0\n");
+    EXPECT_EQ(error, "cat: no_such_file.txt: No such file or directory\n");
+
+    std::remove(filename.c_str());
+}
+
+#ifndef _WIN32
+TEST(RedirectionTest, OptimizedTextFeedsExternalCommands) {
+    std::string output;
+    std::string error;
+
+    EXPECT_EQ(run("echo hello | tr a-z A-Z", output, error), 0);
+    EXPECT_EQ(output, "HELLO\n");
+
+    // An empty echo still sends its newline.
+    EXPECT_EQ(run("echo | tr '\\n' x", output, error), 0);
+    EXPECT_EQ(output, "x");
+}
+#endif
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include "text_counter.h"
+
+namespace {
+
+std::string makeText(size_t size, unsigned seed) {
+    static const char alphabet[] = "ab \t\n\v\f\r\x80\xff_";
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+
+    std::string text;
+    text.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        text += alphabet[pick(rng)];
+    }
+    return text;
+}
+
+TextStats count(const std::string& text, TextCounter::Kernel kernel,
+                size_t blockSize) {
+    TextCounter counter(kernel);
+    for (size_t pos = 0; pos < text.size(); pos += blockSize) {
+        size_t n = std::min(blockSize, text.size() - pos);
+        counter.update(text.data() + pos, n);
+    }
+    return counter.stats();
+}
+
+}  // namespace
+
+TEST(TextCounterTest, CountsLinesWordsBytes) {
+    TextCounter counter;
+    std::string text = "line1\nline2 word2\nline3 word3 word4\n";
+    counter.update(text.data(), text.size());
+
+    EXPECT_EQ(counter.stats().lines, 3);
+    EXPECT_EQ(counter.stats().words, 6);
+    EXPECT_EQ(counter.stats().bytes, 36);
+}
+
+TEST(TextCounterTest, LastLineWithoutNewline) {
+    TextCounter counter;
+    std::string text = "  one two\nthree";
+    counter.update(text.data(), text.size());
+
+    EXPECT_EQ(counter.stats().lines, 1);
+    EXPECT_EQ(counter.stats().words, 3);
+    EXPECT_EQ(counter.stats().bytes, 15);
+}
+
+TEST(TextCounterTest, WordSplitAcrossBlocks) {
+    TextCounter counter;
+    counter.update("hel", 3);
+    counter.update("lo wor", 6);
+    counter.update("ld\n", 3);
+
+    EXPECT_EQ(counter.stats().words, 2);
+    EXPECT_EQ(counter.stats().lines, 1);
+}
+
+TEST(TextCounterTest, KernelsMatchScalar) {
+    const TextCounter::Kernel kernels[] = {TextCounter::Kernel::SSE2,
+                                           TextCounter::Kernel::AVX2};
+    const size_t blockSizes[] = {1, 7, 31, 64, 4096};
+
+    for (unsigned seed = 0; seed < 8; seed++) {
+        std::string text = makeText(10000 + seed * 13, seed);
+        TextStats expected = count(text, TextCounter::Kernel::Scalar, 4096);
+
+        for (auto kernel : kernels) {
+            if (!TextCounter::isSupported(kernel)) {
+                continue;
+            }
+            for (size_t blockSize : blockSizes) {
+                TextStats actual = count(text, kernel, blockSize);
+                EXPECT_EQ(actual.lines, expected.lines);
+                EXPECT_EQ(actual.words, expected.words);
+                EXPECT_EQ(actual.bytes, expected.bytes);
+            }
+        }
+    }
+}
+
+TEST(TextCounterTest, ParallelMatchesSingleThreaded) {
+    std::string text = makeText(100003, 42);
+    text += "straddling_word_at_the_end";
+    TextStats expected = count(text, TextCounter::Kernel::Scalar, 4096);
+
+    for (unsigned threads = 1; threads <= 9; threads++) {
+        TextStats actual =
+            TextCounter::countParallel(text.data(), text.size(), threads);
+        EXPECT_EQ(actual.lines, expected.lines) << threads;
+        EXPECT_EQ(actual.words, expected.words) << threads;
+        EXPECT_EQ(actual.bytes, expected.bytes) << threads;
+    }
+}
+
+TEST(TextCounterTest, ParallelWordsOnChunkBoundaries) {
+    std::string text(64, 'x');
+    for (unsigned threads = 2; threads <= 8; threads++) {
+        TextStats stats =
+            TextCounter::countParallel(text.data(), text.size(), threads);
+        EXPECT_EQ(stats.words, 1) << threads;
+    }
+}